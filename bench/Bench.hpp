@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+
+// Minimal microbenchmark harness for pulsar-bench.
+// Benchmarks register themselves with PULSAR_BENCH and are run from bench/main.cpp.
+namespace bench {
+    struct Case {
+        std::string name;
+        std::function<void()> fn;
+    };
+
+    inline std::vector<Case>& registry() {
+        static std::vector<Case> cases;
+        return cases;
+    }
+
+    struct Registrar {
+        Registrar(const std::string& name, std::function<void()> fn) {
+            registry().push_back({ name, std::move(fn) });
+        }
+    };
+
+    /// Keeps the compiler from optimizing away a computed value
+    template <typename _Tp>
+    inline void keep(const _Tp& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+    /// Runs `fn` until `min_ms` milliseconds have passed and prints the time per iteration.
+    /// `bytes` is the amount of data processed by one iteration (0 - don't print throughput).
+    template <typename _Fn>
+    inline double measure(const std::string& name, _Fn&& fn, size_t bytes = 0, int min_ms = 300) {
+        using clock = std::chrono::steady_clock;
+
+        fn(); // warm up
+
+        size_t iterations = 0;
+        auto start = clock::now();
+        auto elapsed = clock::duration::zero();
+        do {
+            fn();
+            iterations++;
+            elapsed = clock::now() - start;
+        } while (elapsed < std::chrono::milliseconds(min_ms));
+
+        double ns = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+
+        std::cout << "  " << std::setw(44) << std::left << name
+                  << std::setw(14) << std::right << std::fixed << std::setprecision(1) << ns << " ns/iter";
+        if (bytes) std::cout << std::setw(12) << std::setprecision(1) << bytes / ns * 1e9 / (1 << 20) << " MB/s";
+        std::cout << std::endl;
+
+        return ns;
+    }
+};
+
+#define PULSAR_BENCH_CONCAT2(a, b) a##b
+#define PULSAR_BENCH_CONCAT(a, b) PULSAR_BENCH_CONCAT2(a, b)
+
+/// Declares a benchmark group: PULSAR_BENCH("split") { bench::measure(...); }
+#define PULSAR_BENCH(name) \
+    static void PULSAR_BENCH_CONCAT(pulsar_bench_, __LINE__)(); \
+    static bench::Registrar PULSAR_BENCH_CONCAT(pulsar_bench_reg_, __LINE__) { name, PULSAR_BENCH_CONCAT(pulsar_bench_, __LINE__) }; \
+    static void PULSAR_BENCH_CONCAT(pulsar_bench_, __LINE__)()
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "defines"
+#include <cctype>
+#include <string>
+#include <vector>
+
+// Code as it was before the rewrites, kept as the baseline:
+// pulsar-bench times the new versions against it and pulsar-tests checks they give the same results
+namespace legacy {
+    // Checker before the character class table
+    inline const char username_blocked_symbols[] = {
+        ' ', '!', '#', '$', '%', '^', '&', '*', '(', ')',
+        '-', '=', '+', '[', ']', '{', '}', '`', '~', '\047',
+        '"', '<', '>', '?', ',', '.', '/', '|', '\\', ':', ';'
+    };
+
+    inline const std::string username_blocked[] = {
+        "@admin", "@browser", "@server", "@all"
+    };
+
+    inline const char channel_blocked_symbols[] = {
+        ' ', '!', '@', '#', '$', '%', '^', '&', '*', '(', ')',
+        '-', '=', '+', '[', ']', '{', '}', '`', '~', '\047',
+        '"', '<', '>', '?', ',', '.', '/', '|', '\\', ';'
+    };
+
+    inline const std::string channel_blocked[] = {
+        ":server", ":browser"
+    };
+
+    inline bool checkUsername(const std::string& username) {
+        if (username[0] != '@') return false;
+        if (username.size() > PULSAR_USERNAME_SIZE) return false;
+
+        for (size_t i = 0; i < sizeof(username_blocked_symbols) / sizeof(char); i++) {
+            if (username.find(username_blocked_symbols[i]) != std::string::npos) return false;
+        }
+
+        for (size_t i = 0; i < sizeof(username_blocked) / sizeof(std::string); i++) {
+            if (username == username_blocked[i]) return false;
+        }
+
+        for (auto i : username) {
+            if (i != tolower(i)) return false;
+        }
+
+        return true;
+    }
+
+    inline bool checkChannelName(const std::string& channel) {
+        if (channel[0] != ':') return false;
+        if (channel.size() > PULSAR_USERNAME_SIZE) return false;
+
+        for (size_t i = 0; i < sizeof(channel_blocked_symbols) / sizeof(char); i++) {
+            if (channel.find(channel_blocked_symbols[i]) != std::string::npos) return false;
+        }
+
+        for (size_t i = 0; i < sizeof(channel_blocked) / sizeof(std::string); i++) {
+            if (channel == channel_blocked[i]) return false;
+        }
+
+        for (auto i : channel) {
+            if (i != tolower(i)) return false;
+        }
+
+        return true;
+    }
+
+    // split() before the Tokenizer rewrite
+    inline std::vector<std::string> split(const std::string& str, char sep = ' ') {
+        std::vector<std::string> result;
+        std::string current;
+        bool opened_quot = false;
+        bool opened_quot2 = false;
+
+        for (char c : str) {
+            if (c == sep && !opened_quot && !opened_quot2) {
+                if (!current.empty()) {
+                    result.push_back(current);
+                    current.clear();
+                }
+            } else if (c == '\'' && !opened_quot2) {
+                opened_quot = !opened_quot;
+            } else if (c == '\"' && !opened_quot) {
+                opened_quot2 = !opened_quot2;
+            } else {
+                current += c;
+            }
+        }
+
+        if (!current.empty()) result.push_back(current);
+
+        return result;
+    }
+};
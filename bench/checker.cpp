@@ -0,0 +1,28 @@
+#include "Bench.hpp"
+#include "Legacy.hpp"
+#include "Network/Checker.hpp"
+
+PULSAR_BENCH("checker") {
+    const std::vector<std::string> names = {
+        "@matmal29", "@a", "@some_long_user_name_1234567890", "@admin", "@Upper", "@with space",
+        "@user;drop", "@all", "@x_y_z", "@пользователь", "@browser", "@12345678901234567890123456789012"
+    };
+
+    bench::measure("legacy checkUsername (x12)", [&] {
+        size_t ok = 0;
+        for (auto& n : names) ok += legacy::checkUsername(n);
+        bench::keep(ok);
+    });
+
+    bench::measure("checkUsername (x12)", [&] {
+        size_t ok = 0;
+        for (auto& n : names) ok += Checker::checkUsername(n);
+        bench::keep(ok);
+    });
+
+    bench::measure("checkChannelName (x12)", [&] {
+        size_t ok = 0;
+        for (auto& n : names) ok += Checker::checkChannelName(n);
+        bench::keep(ok);
+    });
+}
@@ -0,0 +1,68 @@
+#include "Bench.hpp"
+#include "defines"
+#include "Other/Message.hpp"
+#include "Other/Profile.hpp"
+#include "Other/Chat.hpp"
+#include <fstream>
+
+PULSAR_BENCH("codec") {
+    Message msg { 4171, 1700000000, "@matmal29", ":all", "Привет! This is a typical chat message of moderate length." };
+    const auto payload = msg.to_payload();
+
+    bench::measure("Message::to_payload", [&] {
+        bench::keep(msg.to_payload());
+    }, payload.size());
+
+    bench::measure("Message::from_payload", [&] {
+        bench::keep(Message::from_payload(payload));
+    }, payload.size());
+
+    Profile profile { "description", "user@example.com", "Real Name", Datetime(946684800) };
+    const auto profile_payload = profile.to_payload();
+
+    bench::measure("Profile::to_payload", [&] {
+        bench::keep(profile.to_payload());
+    });
+
+    bench::measure("Profile::from_payload", [&] {
+        bench::keep(Profile::from_payload(profile_payload));
+    });
+}
+
+// Resident set size in bytes, 0 where /proc is not available
+static size_t resident_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    if (!(statm >> pages >> resident)) return 0;
+    return resident * 4096;
+}
+
+// 100k messages from 300 senders, names as long as real ones tend to be
+PULSAR_BENCH("history") {
+    const size_t count = 100000;
+    std::string history;
+    for (size_t i = 1; i <= count; i++) {
+        Message msg { i, 1700000000 + (time_t)i, "@participant_" + std::to_string(i % 300), i % 3 ? ":general_discussion" : "@matmal29",
+                      "message number " + std::to_string(i) + ", some text" };
+        history += msg.to_payload();
+        history += PULSAR_SEP;
+    }
+
+    size_t before = resident_bytes();
+    Chat chat(":general_discussion", history);
+    size_t after = resident_bytes();
+    std::cout << "  sizeof(MessageView) " << sizeof(MessageView) << ", resident +" << (after - before) / 1024 << " KB for " << chat.getMessages().size() << " messages" << std::endl;
+
+    bench::measure("Chat (100k messages)", [&] {
+        Chat chat(":general_discussion", history);
+        bench::keep(chat.getMessages().size());
+    }, history.size());
+
+    auto msgs = chat.getMessages();
+    const Message probe { 0, "@participant_7", ":general_discussion", "" };
+    bench::measure("count by sender (100k messages)", [&] {
+        size_t n = 0;
+        for (auto& m : msgs) n += m.src == probe.get_src_symbol();
+        bench::keep(n);
+    });
+}
@@ -0,0 +1,35 @@
+#include "Bench.hpp"
+#include "Encryption/EndPoint.hpp"
+
+PULSAR_BENCH("crypto") {
+    using namespace PulsarCrypto;
+
+    const std::string text = "Hello, this is a message that goes through RSA and PESA.";
+
+    bench::measure("RSA::Generator (random primes)", [&] {
+        Asymmetrical::RSA::Generator gen;
+        bench::keep(gen.getPublic().n);
+    });
+
+    auto keys = end::generate_rsa();
+
+    bench::measure("enc_rsa (57 bytes)", [&] {
+        bench::keep(end::enc_rsa(text, keys.pub));
+    }, text.size());
+
+    auto encrypted = end::enc_rsa(text, keys.pub);
+    bench::measure("dec_rsa (57 bytes)", [&] {
+        bench::keep(end::dec_rsa(encrypted, keys.priv));
+    }, text.size());
+
+    auto pesa = end::generate_sym();
+
+    bench::measure("enc_sym (57 bytes)", [&] {
+        bench::keep(end::enc_sym(text, pesa));
+    }, text.size());
+
+    auto sym_encrypted = end::enc_sym(text, pesa);
+    bench::measure("dec_sym (57 bytes)", [&] {
+        bench::keep(end::dec_sym(sym_encrypted, pesa));
+    }, text.size());
+}
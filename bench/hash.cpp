@@ -0,0 +1,18 @@
+#include "Bench.hpp"
+#include "lib/hash.h"
+
+PULSAR_BENCH("hash") {
+    const std::string password = "correct horse battery staple";
+
+    bench::measure("fnv1a (28 bytes)", [&] {
+        bench::keep(fnv1a(password));
+    }, password.size());
+
+    bench::measure("hasher (one round)", [&] {
+        bench::keep(hasher(password));
+    });
+
+    bench::measure("hash (PULSAR_HASH_ITERATIONS rounds)", [&] {
+        bench::keep(hash(password));
+    });
+}
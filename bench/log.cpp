@@ -0,0 +1,112 @@
+#include "Bench.hpp"
+#include "defines"
+#include "Network/Database.hpp"
+#include "Network/MessageLog.hpp"
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#ifdef __linux__
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+// Drops a file from the page cache, so the next read of it goes to the disk (Linux only)
+static void evict(const std::filesystem::path& path) {
+#ifdef __linux__
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+#endif
+}
+
+static void evict_dir(const std::filesystem::path& dir) {
+    for (auto& file : std::filesystem::recursive_directory_iterator(dir)) evict(file.path());
+}
+
+// A bridge's view of the traffic: 300 busy channels, messages of a typical length
+static std::vector<Message> traffic(size_t first_id, size_t count) {
+    std::vector<Message> batch;
+    batch.reserve(count);
+    for (size_t id = first_id; id < first_id + count; id++) {
+        batch.emplace_back(id, 1700000000 + (time_t)id, Symbol("@user" + std::to_string(id % 1000)), Symbol(":channel" + std::to_string(id % 300)),
+                           "message " + std::to_string(id) + " with some text to make it look like a real chat line");
+    }
+    return batch;
+}
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Sustained ingest of `total` messages in batches of `per_batch` from `writers` threads, in messages per second
+static double ingest(HistoryStore& store, size_t total, size_t per_batch, size_t writers) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < writers; w++) {
+        threads.emplace_back([&, w] {
+            for (size_t first = 1 + w * per_batch; first <= total; first += writers * per_batch) {
+                store.store_history(traffic(first, per_batch));
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    return total / since(start);
+}
+
+// Open + first read of one chat with nothing in the page cache, averaged over a few chats
+static void cold_read(const std::string& name, const std::function<std::unique_ptr<HistoryStore>()>& open, const std::function<void()>& evict_files) {
+    const int rounds = 10;
+    double open_s = 0, read_s = 0;
+    for (int i = 0; i < rounds; i++) {
+        evict_files();
+        auto start = std::chrono::steady_clock::now();
+        auto store = open();
+        open_s += since(start);
+
+        start = std::chrono::steady_clock::now();
+        bench::keep(store->history(":channel" + std::to_string(i * 29 % 300)).size());
+        read_s += since(start);
+    }
+    std::cout << "  " << std::setw(44) << std::left << name
+              << "open " << std::fixed << std::setprecision(2) << open_s / rounds * 1e3 << " ms, 50 newest of a chat "
+              << read_s / rounds * 1e3 << " ms" << std::endl;
+}
+
+PULSAR_BENCH("history log") {
+    const size_t total = 200000, per_batch = 100;
+    const std::string user = "@bench_history";
+    const std::string db_path = "pulsar_" + user + ".db";
+    const std::filesystem::path log_dir = "pulsar-bench-log";
+
+    auto rate = [](const std::string& name, double per_second) {
+        std::cout << "  " << std::setw(44) << std::left << name << std::fixed << std::setprecision(0) << per_second << " messages/s" << std::endl;
+    };
+
+    std::filesystem::remove(db_path);
+    {
+        Database db { user };
+        rate("SQLite ingest, 1 writer", ingest(db, total, per_batch, 1));
+    }
+    cold_read("SQLite cold read", [&] { return std::make_unique<Database>(user); }, [&] { evict(db_path); });
+    std::filesystem::remove(db_path);
+
+    std::filesystem::remove_all(log_dir);
+    {
+        MessageLog log { log_dir, user };
+        rate("MessageLog ingest, 1 writer", ingest(log, total, per_batch, 1));
+    }
+    std::filesystem::remove_all(log_dir);
+    {
+        // small segments, so sealing and background compaction happen during the run
+        MessageLog log { log_dir, user, 4 << 20 };
+        rate("MessageLog ingest, 4 writers (group commit)", ingest(log, total, per_batch, 4));
+        std::cout << "  segments: " << log.segments() << std::endl;
+    }
+    cold_read("MessageLog cold read", [&] { return std::make_unique<MessageLog>(log_dir, user, 4 << 20); }, [&] { evict_dir(log_dir); });
+    std::filesystem::remove_all(log_dir);
+}
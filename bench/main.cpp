@@ -0,0 +1,17 @@
+#include "Bench.hpp"
+#include <cstring>
+
+// Usage: pulsar-bench [filter]
+// Runs every registered benchmark group whose name contains `filter`.
+int main(int argc, const char** argv) {
+    const char* filter = argc > 1 ? argv[1] : "";
+
+    for (auto& c : bench::registry()) {
+        if (c.name.find(filter) == std::string::npos) continue;
+
+        std::cout << "[" << c.name << "]" << std::endl;
+        c.fn();
+    }
+
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include "Bench.hpp"
+#include "defines"
+#include "Other/Metrics.hpp"
+#include <thread>
+#include <atomic>
+
+// Hot-path cost of the metrics registry: one counter increment, one histogram record,
+// and the same from four threads at once (shards keep them off each other's cache lines)
+PULSAR_BENCH("metrics") {
+    Metrics::Counter counter;
+    Metrics::Histogram histogram;
+    uint64_t value = 0;
+
+    bench::measure("Counter::inc", [&] { counter.inc(); });
+    bench::measure("Histogram::record", [&] { histogram.record(value++ * 7919 % 10000000); });
+    bench::measure("Timer (two clock reads + record)", [&] { Metrics::Timer timer(histogram); });
+
+    const int threads = 4, per_thread = 2000000;
+    for (auto name : { "Counter::inc, 4 threads", "Histogram::record, 4 threads" }) {
+        bool is_counter = name[0] == 'C';
+        std::atomic<int> ready = 0;
+        std::vector<std::thread> workers;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] {
+                ready++;
+                while (ready < threads) {}
+                for (int i = 0; i < per_thread; i++) {
+                    if (is_counter) counter.inc();
+                    else histogram.record((uint64_t)(i * 31 + t));
+                }
+            });
+        }
+        for (auto& w : workers) w.join();
+
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / per_thread;
+        std::cout << "  " << std::setw(44) << std::left << name
+                  << std::setw(14) << std::right << std::fixed << std::setprecision(1) << ns << " ns/iter" << std::endl;
+    }
+
+    auto snap = histogram.snapshot();
+    std::cout << "  recorded " << snap.count << ", p50 " << snap.quantile(0.5) << " ns, p99 " << snap.quantile(0.99) << " ns" << std::endl;
+}
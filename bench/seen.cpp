@@ -0,0 +1,32 @@
+#include "Bench.hpp"
+#include "defines"
+#include "Other/SeenFilter.hpp"
+#include <string>
+#include <vector>
+
+// Duplicate check of one incoming id: new ids in order, reordered ones inside the window, and repeats
+PULSAR_BENCH("seen filter") {
+    std::vector<std::string> chats;
+    for (int i = 0; i < 300; i++) chats.push_back(":channel" + std::to_string(i));
+
+    SeenFilter filter;
+    size_t next = 1, n = 0;
+    bench::measure("note, new id in order (300 chats)", [&] {
+        bench::keep(filter.note(chats[n++ % chats.size()], next));
+        if (n % chats.size() == 0) next++;
+    });
+
+    bench::measure("note, repeated id", [&] {
+        size_t k = n++ % 64;
+        bench::keep(filter.note(chats[n % chats.size()], next > 64 ? next - 1 - k : 1));
+    });
+
+    SeenFilter reordered;
+    size_t id = 1;
+    bench::measure("note, ids swapped in pairs", [&] {
+        bench::keep(reordered.note(":all", id % 2 ? id + 1 : id - 1));
+        id++;
+    });
+
+    std::cout << "  " << filter.size() << " chats, " << sizeof(uint64_t) * PULSAR_SEEN_WINDOW / 64 << " bytes of bitmap each" << std::endl;
+}
@@ -0,0 +1,74 @@
+#include "Bench.hpp"
+#include "defines"
+#include "API/PulsarAPI.hpp"
+#include <SFML/Network.hpp>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+
+// Burst of 10k messages through a loopback socket into a sink that only counts bytes:
+// caller-side time of synchronous socket->send() against the queued PulsarAPI::send()
+PULSAR_BENCH("send") {
+    const int count = 10000;
+    const std::string user = "@bench";
+    const std::string path = "pulsar_" + user + ".db";
+
+    sf::TcpListener listener;
+    if (listener.listen(sf::Socket::AnyPort, sf::IpAddress::LocalHost) != sf::Socket::Status::Done) {
+        std::cout << "  cannot listen on loopback" << std::endl;
+        return;
+    }
+
+    std::atomic<size_t> sunk = 0;
+    std::thread sink([&] {
+        sf::TcpSocket peer;
+        if (listener.accept(peer) != sf::Socket::Status::Done) return;
+
+        std::vector<char> buffer(1 << 16);
+        size_t received = 0;
+        while (peer.receive(buffer.data(), buffer.size(), received) == sf::Socket::Status::Done) sunk += received;
+    });
+
+    auto report = [](const std::string& name, std::chrono::steady_clock::duration elapsed) {
+        double ns = std::chrono::duration<double, std::nano>(elapsed).count() / count;
+        std::cout << "  " << std::setw(44) << std::left << name
+                  << std::setw(14) << std::right << std::fixed << std::setprecision(1) << ns << " ns/msg" << std::endl;
+    };
+
+    {
+        PulsarAPI api { nullptr, user };
+        if (!api.connect("127.0.0.1", listener.getLocalPort())) {
+            sink.join();
+            return;
+        }
+
+        const auto payload = Message { 0, 1700000000, user, ":all", "burst message text" }.to_payload();
+        using clock = std::chrono::steady_clock;
+
+        auto wait_sink = [&](size_t expected) {
+            while (sunk < expected) std::this_thread::yield();
+        };
+
+        auto start = clock::now();
+        for (int i = 0; i < count; i++) (void)api.getSocket()->send(payload.data(), payload.size());
+        report("socket->send (synchronous, caller)", clock::now() - start);
+        wait_sink(count * payload.size());
+
+        size_t rejected = 0;
+        start = clock::now();
+        for (int i = 0; i < count; i++) rejected += !api.sendRaw(payload);
+        auto queued = clock::now() - start;
+        api.flush();
+        auto drained = clock::now() - start;
+
+        report("PulsarAPI::sendRaw (queued, caller)", queued);
+        report("PulsarAPI::sendRaw (until written)", drained);
+        if (rejected) std::cout << "  rejected by backpressure: " << rejected << std::endl;
+        wait_sink(2 * count * payload.size() - rejected * payload.size());
+
+        api.disconnect();
+    }
+
+    sink.join();
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,61 @@
+#include "Bench.hpp"
+#include "Legacy.hpp"
+#include "Other/Chat.hpp"
+
+// ~1 MB of PULSAR_SEP-joined message payloads, as returned by !chat
+static std::string make_history(size_t bytes) {
+    std::string history;
+    for (size_t i = 1; history.size() < bytes; i++) {
+        Message msg { i, 1700000000 + (time_t)i, "@user" + std::to_string(i % 300), ":all",
+                      "message number " + std::to_string(i) + ", some text to make it look like a real chat line" };
+        history += msg.to_payload();
+        history += PULSAR_SEP;
+    }
+    return history;
+}
+
+PULSAR_BENCH("split") {
+    const auto history = make_history(1 << 20);
+    const size_t lines = legacy::split(history, PULSAR_SEP).size();
+    std::cout << "  history: " << history.size() << " bytes, " << lines << " lines" << std::endl;
+
+    bench::measure("legacy split (1 MB history)", [&] {
+        bench::keep(legacy::split(history, PULSAR_SEP).size());
+    }, history.size());
+
+    bench::measure("split (1 MB history)", [&] {
+        bench::keep(split(history, PULSAR_SEP).size());
+    }, history.size());
+
+    std::string buffer;
+    bench::measure("Tokenizer (1 MB history)", [&] {
+        buffer = history;
+        size_t n = 0;
+        for (auto line : Tokenizer(buffer, PULSAR_SEP)) n += line.size();
+        bench::keep(n);
+    }, history.size());
+
+    // what Chat did before ChatArena: a Message (and its text) per line
+    bench::measure("legacy split + Message per line (1 MB history)", [&] {
+        std::vector<Message> messages;
+        for (auto& line : legacy::split(history, PULSAR_SEP)) messages.push_back(Message::from_payload(line));
+        bench::keep(messages.size());
+    }, history.size());
+
+    bench::measure("Chat (1 MB history)", [&] {
+        Chat chat { ":all", history };
+        bench::keep(chat.getMessages().size());
+    }, history.size());
+
+    std::string command = "!contact add @someone 'Some Long Name'";
+    bench::measure("legacy split (console command)", [&] {
+        bench::keep(legacy::split(command).size());
+    });
+
+    bench::measure("Tokenizer (console command)", [&] {
+        buffer = command;
+        size_t n = 0;
+        for (auto token : Tokenizer(buffer)) n += token.size();
+        bench::keep(n);
+    });
+}
@@ -0,0 +1,153 @@
+#include "Bench.hpp"
+#include "defines"
+#include "Network/Database.hpp"
+#include "Other/Chat.hpp"
+#include <chrono>
+#include <filesystem>
+
+PULSAR_BENCH("sqlite") {
+    const std::string user = "@bench";
+    const std::string path = "pulsar_" + user + ".db";
+    std::filesystem::remove(path);
+
+    {
+        bench::measure("Database open (existing file)", [&] {
+            Database db { user };
+            bench::keep(db);
+        }, 0, 100);
+
+        Database db { user };
+        size_t id = 0;
+
+        bench::measure("store_unread", [&] {
+            id++;
+            db.store_unread(Message { id, 1700000000 + (time_t)id, "@sender", ":all", "unread message text" });
+        }, 0, 100);
+
+        std::cout << "  unread rows: " << id << std::endl;
+
+        bench::measure("get_unread (all rows)", [&] {
+            bench::keep(db.get_unread().size());
+        }, 0, 100);
+
+        bench::measure("is_channel_member", [&] {
+            bench::keep(db.is_channel_member(":all"));
+        }, 0, 100);
+
+        bench::measure("contact_name (miss)", [&] {
+            bench::keep(db.contact_name("@nobody"));
+        }, 0, 100);
+
+        db.add_contact("@sender", "Sender");
+        bench::measure("contact (hit)", [&] {
+            bench::keep(db.contact(Message { 1, 1700000000, "@sender", ":all", "text" }));
+        }, 0, 100);
+    }
+
+    std::filesystem::remove(path);
+
+    {
+        bench::measure("Database open (new file)", [&] {
+            std::filesystem::remove(path);
+            Database db { user };
+            bench::keep(db);
+        }, 0, 100);
+
+        // 100k unread rows in one transaction, times out of insertion order so ORDER BY time has to work
+        const size_t rows = 100000;
+        {
+            SQLite3Database raw { path };
+            raw.execute("WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < " + std::to_string(rows) + ") "
+                        "INSERT INTO unread(username, id, time, src, dst, msg) "
+                        "SELECT '" + user + "', i, 1700000000 + (i * 7919) % " + std::to_string(rows) + ", '@sender', ':chat' || (i % 50), 'unread message text' FROM n;");
+        }
+
+        bench::measure("Database open (100k unread rows)", [&] {
+            Database db { user };
+            bench::keep(db);
+        }, 0, 100);
+
+        Database db { user };
+        bench::measure("get_unread (100k rows)", [&] {
+            bench::keep(db.get_unread().size());
+        }, 0, 1000);
+
+        bench::measure("get_unread (one chat of 50)", [&] {
+            bench::keep(db.get_unread(":chat7").size());
+        }, 0, 300);
+
+        bench::measure("unread_count (total)", [&] {
+            bench::keep(db.unread_count());
+        }, 0, 100);
+
+        bench::measure("unread_by_chat (50 chats)", [&] {
+            bench::keep(db.unread_by_chat().size());
+        }, 0, 100);
+    }
+
+    std::filesystem::remove(path);
+}
+
+// FTS5 search over a million stored messages, words drawn from a small Russian vocabulary
+PULSAR_BENCH("search") {
+    const std::string user = "@bench";
+    const std::string path = "pulsar_" + user + ".db";
+    const size_t rows = 1000000;
+    std::filesystem::remove(path);
+
+    {
+        Database db { user };
+
+        auto start = std::chrono::steady_clock::now();
+        {
+            SQLite3Database raw { path };
+            std::string vocab = "привет мир сообщение канал встреча завтра сегодня проект сервер клиент "
+                                "ошибка сборка релиз тест база данных поиск индекс запрос ответ "
+                                "пароль профиль контакт время вечер утро обед кофе документ файл "
+                                "ссылка новости погода работа отпуск праздник";
+            raw.execute("CREATE TEMP TABLE vocab (k INTEGER PRIMARY KEY, word TEXT);");
+            size_t k = 0;
+            for (auto& word : split(vocab)) raw.execute("INSERT INTO vocab VALUES (" + std::to_string(k++) + ", '" + word + "');");
+            const auto n = std::to_string(k);
+
+            raw.execute("BEGIN; WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < " + std::to_string(rows) + ") "
+                        "INSERT INTO history(username, chat, id, time, src, dst, msg) "
+                        "SELECT '" + user + "', ':chat' || (i % 50), i, 1700000000 + i, '@sender', ':chat' || (i % 50), "
+                        "(SELECT word FROM vocab WHERE k = i % " + n + ") || ' ' || "
+                        "(SELECT word FROM vocab WHERE k = (i / " + n + ") % " + n + ") || ' ' || "
+                        "(SELECT word FROM vocab WHERE k = (i * 7919) % " + n + ") || ' номер ' || i FROM n; COMMIT;");
+        }
+        std::cout << "  indexed " << rows << " messages in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+
+        bench::measure("search, one word, first page", [&] {
+            bench::keep(db.search("встреча").size());
+        }, 0, 1000);
+
+        bench::measure("search, two words", [&] {
+            bench::keep(db.search("встреча завтра").size());
+        }, 0, 1000);
+
+        bench::measure("search, prefix", [&] {
+            bench::keep(db.search("сооб*").size());
+        }, 0, 1000);
+
+        bench::measure("search, one chat", [&] {
+            bench::keep(db.search("кофе утро", ":chat7").size());
+        }, 0, 1000);
+
+        bench::measure("search, common word in one chat", [&] {
+            bench::keep(db.search("встреча", ":chat7").size());
+        }, 0, 1000);
+
+        bench::measure("search, page past the ranked matches", [&] {
+            bench::keep(db.search("встреча", "", 20, 5000).size());
+        }, 0, 1000);
+
+        bench::measure("search, rare word", [&] {
+            bench::keep(db.search("123456").size());
+        }, 0, 300);
+    }
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,374 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <map>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "../Other/Trace.hpp"
+
+// Coroutine support for PulsarAPI: Task<T>, a small thread pool Executor with timers,
+// whenAll() to run independent tasks concurrently and syncWait() for the blocking wrappers.
+namespace Async {
+    using Clock = std::chrono::steady_clock;
+
+    // Worker threads run posted jobs and due timers in order.
+    class Executor {
+    private:
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::deque<std::function<void()>> jobs;
+        std::multimap<Clock::time_point, std::function<void()>> timers;
+        std::vector<std::thread> workers;
+        bool stopping = false;
+
+        static Executor*& current() {
+            static thread_local Executor* executor = nullptr;
+            return executor;
+        }
+
+        // Pops the next runnable job into `job`, waits at most until `until`
+        bool next(std::unique_lock<std::mutex>& lk, std::function<void()>& job, Clock::time_point until) {
+            while (true) {
+                auto now = Clock::now();
+                if (!timers.empty() && timers.begin()->first <= now) {
+                    job = std::move(timers.begin()->second);
+                    timers.erase(timers.begin());
+                    return true;
+                }
+                if (!jobs.empty()) {
+                    job = std::move(jobs.front());
+                    jobs.pop_front();
+                    return true;
+                }
+                if (stopping || now >= until) return false;
+
+                auto wake = timers.empty() ? until : std::min(until, timers.begin()->first);
+                if (wake == Clock::time_point::max()) cv.wait(lk);
+                else cv.wait_until(lk, wake);
+            }
+        }
+
+        void work() {
+            PULSAR_TRACE_THREAD("executor");
+            current() = this;
+            std::function<void()> job;
+            std::unique_lock lk(mtx);
+            while (next(lk, job, Clock::time_point::max())) {
+                lk.unlock();
+                job();
+                job = nullptr;
+                lk.lock();
+            }
+        }
+
+    public:
+        Executor(size_t threads = 1) {
+            if (threads == 0) threads = 1;
+            for (size_t i = 0; i < threads; i++) workers.emplace_back(&Executor::work, this);
+        }
+
+        ~Executor() {
+            {
+                std::lock_guard lk(mtx);
+                stopping = true;
+            }
+            cv.notify_all();
+            for (auto& w : workers) w.join();
+        }
+
+        Executor(const Executor&) = delete;
+        Executor& operator=(const Executor&) = delete;
+
+        /// Process-wide executor used by PulsarAPI unless another one is given
+        static Executor& shared() {
+            static Executor executor { 2 };
+            return executor;
+        }
+
+        bool inWorker() { return current() == this; }
+
+        void post(std::function<void()> job) {
+            {
+                std::lock_guard lk(mtx);
+                jobs.push_back(std::move(job));
+            }
+            cv.notify_one();
+        }
+
+        void postAt(Clock::time_point when, std::function<void()> job) {
+            {
+                std::lock_guard lk(mtx);
+                timers.emplace(when, std::move(job));
+            }
+            cv.notify_one();
+        }
+
+        /// Runs jobs on the calling thread until `done()`. Used when a worker blocks in syncWait()
+        /// so that the work it waits for cannot starve behind it.
+        template <typename _Pred>
+        void runUntil(_Pred done) {
+            std::function<void()> job;
+            std::unique_lock lk(mtx);
+            while (!done()) {
+                if (!next(lk, job, Clock::now() + std::chrono::milliseconds(10))) continue;
+                lk.unlock();
+                job();
+                job = nullptr;
+                lk.lock();
+            }
+        }
+
+        /// co_await executor.schedule() - continue on a worker thread
+        auto schedule() {
+            struct Awaiter {
+                Executor& ex;
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> h) { ex.post([h] { h.resume(); }); }
+                void await_resume() const noexcept {}
+            };
+            return Awaiter { *this };
+        }
+
+        /// co_await executor.sleep(100ms) - resume on a worker thread after the delay
+        auto sleep(Clock::duration delay) {
+            struct Awaiter {
+                Executor& ex;
+                Clock::time_point when;
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> h) { ex.postAt(when, [h] { h.resume(); }); }
+                void await_resume() const noexcept {}
+            };
+            return Awaiter { *this, Clock::now() + delay };
+        }
+    };
+
+    template <typename _Tp>
+    class Task;
+
+    namespace detail {
+        // Continuation slot shared between a task and its awaiter.
+        // nullptr - running, done() - finished, anything else - the awaiting coroutine.
+        struct PromiseBase {
+            std::atomic<void*> state = nullptr;
+            std::exception_ptr error;
+
+            static void* done() { return reinterpret_cast<void*>(1); }
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+
+            auto final_suspend() noexcept;
+
+            void unhandled_exception() { error = std::current_exception(); }
+        };
+
+        // Resumes the awaiter, if it is already waiting
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+
+            template <typename _Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<_Promise> h) noexcept {
+                void* prev = h.promise().state.exchange(PromiseBase::done());
+                if (prev) return std::coroutine_handle<>::from_address(prev);
+                return std::noop_coroutine();
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        inline auto PromiseBase::final_suspend() noexcept { return FinalAwaiter {}; }
+
+        template <typename _Tp>
+        struct Promise : PromiseBase {
+            std::optional<_Tp> value;
+
+            Task<_Tp> get_return_object();
+
+            template <typename _Up>
+            void return_value(_Up&& v) { value.emplace(std::forward<_Up>(v)); }
+
+            _Tp result() {
+                if (error) std::rethrow_exception(error);
+                return std::move(*value);
+            }
+        };
+
+        template <>
+        struct Promise<void> : PromiseBase {
+            Task<void> get_return_object();
+
+            void return_void() {}
+
+            void result() {
+                if (error) std::rethrow_exception(error);
+            }
+        };
+    }
+
+    /// Lazy coroutine task. Starts when awaited (or start()ed) and resumes its awaiter when done.
+    /// A started task must be awaited before it is destroyed.
+    template <typename _Tp = void>
+    class [[nodiscard]] Task {
+    public:
+        using promise_type = detail::Promise<_Tp>;
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+        bool started = false;
+
+    public:
+        explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+
+        Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)), started(other.started) {}
+
+        Task& operator=(Task&& other) noexcept {
+            if (this != &other) {
+                if (handle) handle.destroy();
+                handle = std::exchange(other.handle, nullptr);
+                started = other.started;
+            }
+            return *this;
+        }
+
+        ~Task() {
+            if (handle) handle.destroy();
+        }
+
+        /// Runs the task on the calling thread until its first suspension (e.g. a request was sent)
+        void start() {
+            if (started) return;
+            started = true;
+            handle.resume();
+        }
+
+        bool await_ready() const noexcept { return false; }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) {
+            if (!started) {
+                started = true;
+                handle.promise().state.store(awaiter.address());
+                return handle;
+            }
+
+            void* expected = nullptr;
+            if (handle.promise().state.compare_exchange_strong(expected, awaiter.address())) return std::noop_coroutine();
+            return awaiter;     // already finished
+        }
+
+        _Tp await_resume() { return handle.promise().result(); }
+    };
+
+    template <typename _Tp>
+    Task<_Tp> detail::Promise<_Tp>::get_return_object() {
+        return Task<_Tp> { std::coroutine_handle<Promise<_Tp>>::from_promise(*this) };
+    }
+
+    inline Task<void> detail::Promise<void>::get_return_object() {
+        return Task<void> { std::coroutine_handle<Promise<void>>::from_promise(*this) };
+    }
+
+    /// Starts all tasks at once and collects the results in order.
+    /// Every task is awaited even if one throws, the first exception is rethrown afterwards.
+    template <typename _Tp>
+    Task<std::vector<_Tp>> whenAll(std::vector<Task<_Tp>> tasks) {
+        for (auto& t : tasks) t.start();
+
+        std::vector<_Tp> results;
+        std::exception_ptr error;
+        results.reserve(tasks.size());
+        for (auto& t : tasks) {
+            try {
+                results.push_back(co_await t);
+            } catch (...) {
+                if (!error) error = std::current_exception();
+            }
+        }
+
+        if (error) std::rethrow_exception(error);
+        co_return results;
+    }
+
+    inline Task<void> whenAll(std::vector<Task<void>> tasks) {
+        for (auto& t : tasks) t.start();
+
+        std::exception_ptr error;
+        for (auto& t : tasks) {
+            try {
+                co_await t;
+            } catch (...) {
+                if (!error) error = std::current_exception();
+            }
+        }
+
+        if (error) std::rethrow_exception(error);
+    }
+
+    namespace detail {
+        struct SyncTask {
+            struct promise_type {
+                SyncTask get_return_object() { return {}; }
+                std::suspend_never initial_suspend() noexcept { return {}; }
+                std::suspend_never final_suspend() noexcept { return {}; }
+                void return_void() {}
+                void unhandled_exception() { std::terminate(); }
+            };
+        };
+    }
+
+    /// Blocks the calling thread until the task finishes. Safe to call from an executor worker.
+    template <typename _Tp>
+    _Tp syncWait(Task<_Tp> task, Executor& executor = Executor::shared()) {
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::atomic_bool finished = false;
+        std::optional<std::conditional_t<std::is_void_v<_Tp>, bool, _Tp>> value;
+        std::exception_ptr error;
+
+        auto runner = [&]() -> detail::SyncTask {
+            // the waiter may return as soon as `finished` is set, only frame locals are used after that
+            auto* ex = &executor;
+            auto* awaited = &task;
+
+            try {
+                if constexpr (std::is_void_v<_Tp>) {
+                    co_await *awaited;
+                    value.emplace(true);
+                } else value.emplace(co_await *awaited);
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            {
+                std::lock_guard lk(mtx);
+                finished = true;
+                cv.notify_all();
+            }
+            ex->post([] {});        // wakes runUntil()
+        };
+        runner();
+
+        // `finished` is read under `mtx`: once it is seen set, the runner has released the lock and is
+        // done with everything on this stack, so returning cannot leave it touching mtx or cv
+        if (executor.inWorker()) executor.runUntil([&] {
+            std::lock_guard lk(mtx);
+            return finished.load();
+        });
+        else {
+            std::unique_lock lk(mtx);
+            cv.wait(lk, [&] { return finished.load(); });
+        }
+
+        if (error) std::rethrow_exception(error);
+        if constexpr (!std::is_void_v<_Tp>) return std::move(*value);
+    }
+}
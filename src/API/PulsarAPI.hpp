@@ -5,28 +5,747 @@
 #include <list>
 #include <iostream>
 #include <mutex>
-
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <map>
+#include <random>
+#include <cstdlib>
+#include <span>
+
+#ifndef _WIN32
+#   include <sys/socket.h>
+#endif
+
+#include "Async.hpp"
+#include "RttEstimator.hpp"
+#include "Transfers.hpp"
+#include "../Other/Metrics.hpp"
+#include "../Other/Trace.hpp"
 #include "../Other/Chat.hpp"
 #include "../Network/Database.hpp"
+#include "../Network/MessageLog.hpp"
+#include "../Network/Poller.hpp"
 #include "../Other/Message.hpp"
 #include "../Other/Profile.hpp"
+#include "../Other/SeenFilter.hpp"
 #include "../lib/hash.h"
 #include "../Network/Checker.hpp"
 #include "../Encryption/EndPoint.hpp"
 
 class PulsarAPI {
-private:
+public:
     struct ServerResponse {
         std::string req, rsp;
     };
 
+    // Priority class of an outbound frame: control frames (requests, chat messages, transfer acks)
+    // are written before queued bulk ones (transfer chunks)
+    enum class Lane {
+        Control,
+        Bulk
+    };
+
+private:
+    // Process-wide metrics, shared by all PulsarAPI instances
+    struct Stats {
+        Metrics::Registry& r = Metrics::Registry::global();
+        Metrics::Counter& messages_sent = r.counter("pulsar_messages_sent_total", "Chat messages put on the wire");
+        Metrics::Counter& messages_received = r.counter("pulsar_messages_received_total", "Chat messages received");
+        Metrics::Counter& duplicates = r.counter("pulsar_duplicates_dropped_total", "Chat messages received again and dropped");
+        Metrics::Counter& messages_offline = r.counter("pulsar_messages_offline_total", "Chat messages kept in the outbox while offline");
+        Metrics::Counter& bytes_sent = r.counter("pulsar_bytes_sent_total", "Bytes written to the socket");
+        Metrics::Counter& bytes_received = r.counter("pulsar_bytes_received_total", "Bytes read from the socket");
+        Metrics::Counter& request_timeouts = r.counter("pulsar_request_timeouts_total", "Requests that got no reply in time");
+        Metrics::Counter& link_drops = r.counter("pulsar_link_drops_total", "Connections lost");
+        Metrics::Counter& reconnects = r.counter("pulsar_reconnects_total", "Connections restored by the reconnect supervisor");
+        Metrics::Gauge& send_queue = r.gauge("pulsar_send_queue_bytes", "Bytes waiting for the sender thread");
+        Metrics::Gauge& pending_requests = r.gauge("pulsar_pending_requests", "Requests waiting for a reply, sent or queued");
+    };
+
+    static Stats& stats() {
+        static Stats instance;
+        return instance;
+    }
+
+    static Metrics::Histogram& requestLatency(const std::string& req) {
+        auto command = req.substr(0, req.find(' '));
+        if (!command.empty() && command[0] == '!') command.erase(0, 1);
+        return Metrics::Registry::global().histogram("pulsar_request_seconds", "Time from issuing a request to its reply, by command", Metrics::label("command", command));
+    }
+
     std::shared_ptr<sf::TcpSocket> socket;
     std::string username;
     Database db;
     std::thread recv_thr;
+    std::string recv_rest;                  // read past the end of the last payload, see recvRaw()
     std::atomic_bool connected = false;
-    std::list<ServerResponse> responses;
-    std::mutex responses_mtx;
+    std::atomic_bool readupto_supported = true;     // cleared when the server rejects !readupto
+    Async::Executor* executor;
+    std::function<void(const Message&)> message_handler;
+    std::mutex handler_mtx;
+
+    // Reconnect state. The reciever thread is also the reconnect supervisor:
+    // when the link drops it reconnects with backoff and starts resumeAsync()
+    std::string host;
+    unsigned short port = 0;
+    std::string session_password;           // for the re-login after a reconnect
+    std::atomic_bool auto_reconnect = false;
+    std::atomic_bool closing = false;       // disconnect() was called, do not reconnect
+    std::mutex link_mtx;                    // socket open/close, closing, session_password
+    std::condition_variable link_cv;        // wakes the backoff sleep on disconnect()
+    std::optional<Async::Task<void>> resume_task;
+    std::atomic<Async::Clock::time_point> last_recv = Async::Clock::now();
+    std::atomic<unsigned> backoff_ms = PULSAR_RECONNECT_MIN_MS;    // reset once a resume logs in
+
+    // While offline, send() stores chat messages in the database outbox instead
+    bool offline = false;
+    std::mutex offline_mtx;
+
+    // Message ids seen per chat in this session: repeats (a server resend, or unread sync and the live loop both
+    // getting a message) are dropped, and resume fetches only what came after the newest one, or after the mark
+    // an earlier session saved for a chat not seen yet
+    SeenFilter seen_ids;
+    std::mutex seen_mtx;
+
+    // Requests waiting for their "!server.msg" reply, matched by the REQ text.
+    // At most PULSAR_REQUEST_WINDOW of them are on the wire, the rest wait here unsent.
+    // Shared with the timeout and keepalive timers, which may fire after the API is gone.
+    struct PendingRequest {
+        uint64_t id;
+        std::string req;
+        std::string payload;
+        std::string* result;            // nullptr and no handle for keepalive pings
+        std::coroutine_handle<> handle;
+        bool bulk = false;              // see isBulk()
+        bool sent = false;
+        Async::Clock::time_point sent_at {};
+    };
+
+    struct Requests {
+        std::mutex mtx;
+        std::list<PendingRequest> list;
+        uint64_t next_id = 0;
+        size_t inflight = 0;
+
+        RttEstimator rtt;
+        bool ping_pending = false;
+        std::atomic<unsigned> missed = 0;  // pings timed out since anything was last received
+
+        std::mutex api_mtx;     // keeps `api` alive while a timer uses it
+        PulsarAPI* api;
+    };
+
+    std::shared_ptr<Requests> requests = std::make_shared<Requests>();
+
+    class RequestAwaiter {
+    private:
+        PulsarAPI& api;
+        std::string req;
+        std::string result;
+    public:
+        RequestAwaiter(PulsarAPI& api, std::string req) : api(api), req(std::move(req)) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> h) {
+            // Once registered the reply may resume the coroutine on another thread
+            // and destroy this awaiter, so only locals are used after that
+            auto self = &api;
+            auto payload = Message { 0, Datetime::now().toTime(), api.username, "!server.req", req }.to_payload();
+            {
+                std::lock_guard lk(api.requests->mtx);
+                api.requests->list.push_back({ ++api.requests->next_id, req, std::move(payload), &result, h, isBulk(req) });
+            }
+            stats().pending_requests.add(1);
+            self->pumpRequests();
+        }
+
+        std::string await_resume() { return std::move(result); }
+    };
+
+    // Removes the request and returns its coroutine, requests->mtx must be held
+    std::coroutine_handle<> takeRequest(std::list<PendingRequest>::iterator i) {
+        auto handle = i->handle;
+        if (!handle) requests->ping_pending = false;
+        if (i->sent) requests->inflight--;
+        requests->list.erase(i);
+        stats().pending_requests.sub(1);
+        return handle;
+    }
+
+    // History fetches: a resume or an unread sync queues hundreds of them at once
+    static bool isBulk(std::string_view req) {
+        auto command = req.substr(0, req.find(' '));
+        return command == "!msg" || command == "!chat";
+    }
+
+    // Puts queued requests on the wire while the window allows, control requests before bulk ones:
+    // a login or a read mark waits for the history fetch on the wire, not for the rest of the sync.
+    // The lanes share the window, replies to requests sent together could arrive glued
+    void pumpRequests() {
+        std::vector<std::pair<uint64_t, std::string>> ready;
+
+        while (true) {
+            {
+                std::lock_guard lk(requests->mtx);
+                for (bool bulk : { false, true }) {
+                    for (auto& p : requests->list) {
+                        if (requests->inflight >= PULSAR_REQUEST_WINDOW) break;
+                        if (p.sent || p.bulk != bulk) continue;
+                        p.sent = true;
+                        p.sent_at = Async::Clock::now();
+                        requests->inflight++;
+                        ready.emplace_back(p.id, std::move(p.payload));
+                    }
+                }
+            }
+            if (ready.empty()) return;
+
+            for (auto& [id, payload] : ready) {
+                if (sendRaw(std::move(payload))) {
+                    executor->postAt(Async::Clock::now() + requests->rtt.timeout(), [weak = std::weak_ptr(requests), id] {
+                        expireRequest(weak, id);
+                    });
+                    continue;
+                }
+
+                std::lock_guard lk(requests->mtx);
+                auto i = std::find_if(requests->list.begin(), requests->list.end(), [id](auto& p) { return p.id == id; });
+                if (i == requests->list.end()) continue;
+                if (auto h = takeRequest(i)) executor->post([h] { h.resume(); });
+            }
+            ready.clear();
+        }
+    }
+
+    static void expireRequest(const std::weak_ptr<Requests>& weak, uint64_t id) {
+        auto requests = weak.lock();
+        if (!requests) return;
+
+        std::coroutine_handle<> handle;
+        {
+            std::lock_guard lk(requests->mtx);
+            auto i = std::find_if(requests->list.begin(), requests->list.end(), [id](auto& p) { return p.id == id; });
+            if (i == requests->list.end()) return;
+            handle = i->handle;
+            if (!handle) requests->ping_pending = false;
+            if (i->sent) requests->inflight--;
+            requests->list.erase(i);
+        }
+        stats().pending_requests.sub(1);
+        stats().request_timeouts.inc();
+
+        // A lost reply alone proves little: without framing the server may have read the request
+        // glued to another payload. Every timeout is followed by a ping, and only unanswered pings
+        // with nothing at all received in between mark the connection as half-open.
+        requests->rtt.backoff();
+        bool dead = !handle && ++requests->missed >= PULSAR_PING_MAX_MISSED;
+        {
+            std::lock_guard lk(requests->api_mtx);
+            if (auto api = requests->api) {
+                if (dead && api->connected) {
+                    std::cout << "Сервер не отвечает." << std::endl;
+                    api->linkDown();
+                } else {
+                    api->pumpRequests();
+                    api->ping(true);
+                }
+            }
+        }
+        if (handle) handle.resume();
+    }
+
+    // Runs every PULSAR_PING_INTERVAL_MS for the lifetime of the API and pings an idle link
+    static void keepalive(const std::weak_ptr<Requests>& weak) {
+        auto requests = weak.lock();
+        if (!requests) return;
+
+        std::lock_guard lk(requests->api_mtx);
+        auto api = requests->api;
+        if (!api) return;
+
+        const auto interval = std::chrono::milliseconds(PULSAR_PING_INTERVAL_MS);
+        if (Async::Clock::now() - api->last_recv.load() >= interval) api->ping();
+        api->executor->postAt(Async::Clock::now() + interval, [weak] { keepalive(weak); });
+    }
+
+    // A request nobody waits for, its reply (whatever the server answers) only proves the link is alive
+    // and feeds the RTT estimate. Unless `probe`, skipped while other requests are pending.
+    void ping(bool probe = false) {
+        if (!connected) return;
+        {
+            std::lock_guard lk(requests->mtx);
+            if (requests->ping_pending || (!probe && !requests->list.empty())) return;
+            requests->ping_pending = true;
+
+            // Replies are matched by REQ text: a pong arriving after its ping timed out must not
+            // complete the next ping with a wrong RTT sample
+            auto id = ++requests->next_id;
+            auto req = "!ping " + std::to_string(id);
+            auto payload = Message { 0, Datetime::now().toTime(), username, "!server.req", req }.to_payload();
+            requests->list.push_back({ id, std::move(req), std::move(payload), nullptr, nullptr });
+        }
+        stats().pending_requests.add(1);
+        pumpRequests();
+    }
+
+    // Resumes every pending request with an empty response
+    void failPending() {
+        std::list<PendingRequest> failed;
+        {
+            std::lock_guard lk(requests->mtx);
+            failed.swap(requests->list);
+            requests->inflight = 0;
+            requests->ping_pending = false;
+        }
+        stats().pending_requests.sub(failed.size());
+        for (auto& p : failed) {
+            if (p.handle) executor->post([h = p.handle] { h.resume(); });
+        }
+    }
+
+    // Outbound queues, only send_thr writes to the socket
+    std::thread send_thr;
+    std::deque<std::string> outbox;             // control: requests and chat messages
+    std::deque<std::string> outbox_bulk;        // transfer chunks
+    size_t outbox_bytes = 0;       // both queues, mirrored in stats().send_queue, change through setOutboxBytes()
+    size_t outbox_bulk_bytes = 0;
+    std::mutex outbox_mtx;
+    std::condition_variable outbox_cv;
+    std::condition_variable drained_cv;
+
+    // outbox_mtx must be held
+    void setOutboxBytes(size_t bytes) {
+        stats().send_queue.add((int64_t)bytes - (int64_t)outbox_bytes);
+        outbox_bytes = bytes;
+    }
+
+    bool writeAll(const std::string& frame) {
+        size_t off = 0;
+        while (off < frame.size()) {
+            size_t sent = 0;
+            auto status = socket->send(frame.data() + off, frame.size() - off, sent);
+            off += sent;
+
+            if (status != sf::Socket::Status::Done && status != sf::Socket::Status::Partial && status != sf::Socket::Status::NotReady) return false;
+        }
+        return true;
+    }
+
+    // Takes every queued control frame and up to PULSAR_BULK_BURST bulk frames after them, and writes
+    // them out frame by frame: control frames never wait for more than a burst of chunks.
+    // Frames are not merged into one write: the protocol has no framing and the server reads one message per recv.
+    void senderLoop() {
+        PULSAR_TRACE_THREAD("sender");
+        std::deque<std::string> batch;
+
+        while (true) {
+            size_t bulk_from;
+            {
+                std::unique_lock lk(outbox_mtx);
+                outbox_cv.wait(lk, [this] { return !outbox.empty() || !outbox_bulk.empty() || !connected; });
+                if (!connected) return;
+                batch.swap(outbox);
+                bulk_from = batch.size();
+                for (size_t n = 0; n < PULSAR_BULK_BURST && !outbox_bulk.empty(); n++) {
+                    batch.push_back(std::move(outbox_bulk.front()));
+                    outbox_bulk.pop_front();
+                }
+            }
+
+            PULSAR_TRACE_SCOPE("write", std::to_string(batch.size()) + " frames");
+            size_t written = 0, bulk_written = 0;
+            for (size_t i = 0; i < batch.size(); i++) {
+                if (!writeAll(batch[i])) {
+                    if (!closing) std::cout << "Не удалось отправить сообщение" << std::endl;
+                    batch.erase(batch.begin(), batch.begin() + i);
+                    linkDown(std::move(batch));
+                    return;
+                }
+                written += batch[i].size();
+                if (i >= bulk_from) bulk_written += batch[i].size();
+            }
+            batch.clear();
+
+            {
+                std::lock_guard lk(outbox_mtx);
+                if (!connected) return;     // disconnect() already dropped the queue
+                setOutboxBytes(outbox_bytes - written);
+                outbox_bulk_bytes -= bulk_written;
+            }
+            stats().bytes_sent.inc(written);
+            drained_cv.notify_all();
+        }
+    }
+
+    // Wakes a reciever blocked in recv(). Only sockets created by PulsarAPI expose their descriptor,
+    // link_mtx must be held
+    bool shutdownSocket() {
+        auto pollable = dynamic_cast<PollableSocket*>(socket.get());
+        if (!pollable) return false;
+#ifdef _WIN32
+        ::shutdown(pollable->getNativeHandle(), SD_BOTH);
+#else
+        ::shutdown(pollable->getNativeHandle(), SHUT_RDWR);
+#endif
+        return true;
+    }
+
+    bool openLink() {
+        if (send_thr.joinable()) send_thr.join();
+
+        std::lock_guard lk(link_mtx);
+        if (closing) return false;
+        if (!socket) socket = std::make_shared<PollableSocket>();
+        if (!dial(*socket, host, port)) return false;
+
+        connected = true;
+        send_thr = std::thread { &PulsarAPI::senderLoop, this };
+        return true;
+    }
+
+    // Called by the sender or reciever thread when the socket fails.
+    // `unsent` and the queued frames are lost unless the API is going to reconnect,
+    // then chat messages among them are kept in the database outbox.
+    void linkDown(std::deque<std::string> unsent = {}) {
+        std::lock_guard offline_lk(offline_mtx);
+        {
+            std::lock_guard lk(outbox_mtx);
+            if (connected.exchange(false)) stats().link_drops.inc();
+            for (auto& frame : outbox) unsent.push_back(std::move(frame));
+            outbox.clear();
+            outbox_bulk.clear();
+            outbox_bulk_bytes = 0;
+            setOutboxBytes(0);
+        }
+        outbox_cv.notify_all();
+        drained_cv.notify_all();
+
+        {
+            std::lock_guard lk(link_mtx);
+            shutdownSocket();
+        }
+
+        if (auto_reconnect && !closing) {
+            offline = true;
+            for (auto& frame : unsent) keepOffline(frame);
+        }
+        failPending();
+        saveSeen();
+    }
+
+    void keepOffline(const std::string& frame) {
+        try {
+            auto msg = Message::from_payload(frame);
+            if (msg.get_dst().empty() || msg.get_dst()[0] == '!') return;     // requests are not repeated
+            if (Transfers::isTransfer(msg)) return;                             // transfers repeat what got lost themselves
+            db.queue_outgoing(msg);
+            stats().messages_offline.inc();
+        } catch (const std::exception&) {}
+    }
+
+    // Runs on the reciever thread after the link dropped: reconnects with jittered exponential backoff
+    // and starts resumeAsync(). Returns false if disconnect() was called meanwhile.
+    bool relink() {
+        PULSAR_TRACE_SCOPE("relink");
+        finishResume();
+        if (send_thr.joinable()) send_thr.join();
+        {
+            std::lock_guard lk(link_mtx);
+            socket->disconnect();
+        }
+        std::cout << "Соединение с сервером потеряно, переподключение..." << std::endl;
+
+        // A link that drops again before the login keeps growing the backoff too
+        std::mt19937 rng { std::random_device {}() };
+        while (true) {
+            // Half of the delay is random, so clients dropped by the same outage do not come back in lockstep
+            unsigned backoff = backoff_ms;
+            auto delay = std::chrono::milliseconds(backoff / 2 + rng() % (backoff / 2 + 1));
+            backoff_ms = std::min<unsigned>(backoff * 2, PULSAR_RECONNECT_MAX_MS);
+            {
+                std::unique_lock lk(link_mtx);
+                if (link_cv.wait_for(lk, delay, [this] { return closing.load(); })) return false;
+            }
+            if (openLink()) break;
+        }
+
+        std::cout << "Соединение восстановлено." << std::endl;
+        stats().reconnects.inc();
+        resume_task.emplace(resumeAsync());
+        resume_task->start();
+        return true;
+    }
+
+    // The previous resume may still be running if the link dropped again in the middle of it
+    void finishResume() {
+        if (!resume_task) return;
+        try {
+            Async::syncWait(std::move(*resume_task), *executor);
+        } catch (const std::exception&) {}
+        resume_task.reset();
+    }
+
+    void stopReciever() {
+        if (!recv_thr.joinable()) return;
+        if (recv_thr.get_id() == std::this_thread::get_id() || !dynamic_cast<PollableSocket*>(socket.get())) {
+            recv_thr.detach();  // cannot be woken, it exits on its own once recv() fails
+            return;
+        }
+        recv_thr.join();
+        finishResume();
+    }
+
+    /// Logs in again, sends what was typed offline, then fetches only messages newer
+    /// than the last one seen in each chat instead of a full unread resync
+    Async::Task<void> resumeAsync() {
+        PULSAR_TRACE_ASYNC("resume");
+        std::string password;
+        {
+            std::lock_guard lk(link_mtx);
+            password = session_password;
+        }
+
+        if (co_await loginAsync(password) != LoginResult::Success) {
+            if (!connected) co_return;      // dropped again, the next resume retries
+            std::cout << "Не удалось восстановить сессию, войдите заново." << std::endl;
+            closing = true;
+            linkDown();
+            co_return;
+        }
+
+        backoff_ms = PULSAR_RECONNECT_MIN_MS;
+        flushOutbox();
+
+        std::map<std::string, size_t> seen;
+        {
+            std::lock_guard lk(seen_mtx);
+            seen = seen_ids.marks();
+        }
+
+        // Unread messages of chats not seen before, the others are covered by fetchAfterAsync()
+        auto response = co_await requestAsync("getUnread");
+        std::vector<Async::Task<Message>> unread;
+        for (auto entry : Tokenizer(response, ';')) {
+            auto bar = entry.find('|');
+            if (bar == std::string_view::npos) continue;
+
+            std::string chat { entry.substr(0, bar) };
+            if (seen.count(chat)) continue;
+            unread.push_back(getMessageByIdAsync(chat, std::stoull(std::string(entry.substr(bar + 1)))));
+        }
+        for (auto& msg : co_await Async::whenAll(std::move(unread))) {
+            // still unread even if the live loop showed it, store_unread() ignores repeats
+            if (!Transfers::isTransfer(msg)) db.store_unread(msg);
+            if (!noteSeen(msg)) {
+                stats().duplicates.inc();
+                continue;
+            }
+            deliver(msg);
+        }
+
+        std::vector<Async::Task<std::vector<Message>>> missed;
+        for (auto& [chat, id] : seen) missed.push_back(fetchAfterAsync(chat, id));
+        for (auto& chat : co_await Async::whenAll(std::move(missed))) {
+            for (auto& msg : chat) deliver(msg);
+        }
+    }
+
+    /// Messages of `chat` after id `after`, one by one until the server has none
+    Async::Task<std::vector<Message>> fetchAfterAsync(std::string chat, size_t after) {
+        std::vector<Message> res;
+        for (size_t id = after + 1; id <= after + PULSAR_RESUME_MAX_MESSAGES; id++) {
+            auto response = co_await requestAsync("msg", chat, id);
+            if (response.empty()) break;
+
+            Message msg;
+            try {
+                msg = Message::from_payload(response);
+            } catch (const std::exception&) {
+                break;
+            }
+
+            if (!noteSeen(chat, id)) break;     // arrived live after the login, so did everything after it
+            if (msg.get_src() != username) res.emplace_back(id, msg.get_time().toTime(), msg.get_src_symbol(), Symbol(chat), msg.get_msg());
+        }
+        co_return res;
+    }
+
+    // Everything typed while offline goes out as one batch, in order
+    void flushOutbox() {
+        std::lock_guard lk(offline_mtx);
+
+        int64_t flushed = -1;
+        for (auto& [seq, msg] : db.get_outbox()) {
+            if (!sendRaw(msg.to_payload())) break;
+            stats().messages_sent.inc();
+            flushed = seq;
+        }
+        if (flushed >= 0) db.remove_outbox(flushed);
+        offline = !connected;
+    }
+
+    // Chat of an incoming message as the server names it in !msg and !getUnread
+    std::string chatOf(const Message& msg) {
+        auto& dst = msg.get_dst();
+        if (!dst.empty() && dst[0] == '@' && dst == username) return msg.get_src();
+        return dst;
+    }
+
+    /// @return false if the message was already seen in the chat
+    bool noteSeen(const std::string& chat, size_t id) {
+        std::lock_guard lk(seen_mtx);
+        return seen_ids.note(chat, id);
+    }
+
+    bool noteSeen(const Message& msg) {
+        return noteSeen(chatOf(msg), msg.get_id());
+    }
+
+    void saveSeen() {
+        std::map<std::string, size_t> seen;
+        {
+            std::lock_guard lk(seen_mtx);
+            seen = seen_ids.marks();
+        }
+        try {
+            db.save_last_seen(seen);
+        } catch (const std::exception&) {}
+    }
+
+    // Messages on their way into the searchable history, written in one transaction
+    // PULSAR_HISTORY_FLUSH_MS after the first of them arrives
+    std::mutex history_mtx;
+    std::vector<Message> history_pending;
+    std::unique_ptr<MessageLog> log;        // takes the history instead of db if PULSAR_HISTORY_LOG is set
+
+    HistoryStore& historyStore() {
+        if (log) return *log;
+        return db;
+    }
+
+    void remember(const std::vector<Message>& msgs) {
+        if (msgs.empty()) return;
+
+        bool schedule;
+        {
+            std::lock_guard lk(history_mtx);
+            schedule = history_pending.empty();
+            history_pending.insert(history_pending.end(), msgs.begin(), msgs.end());
+        }
+        if (schedule) {
+            executor->postAt(Async::Clock::now() + std::chrono::milliseconds(PULSAR_HISTORY_FLUSH_MS), [weak = std::weak_ptr(requests)] {
+                auto requests = weak.lock();
+                if (!requests) return;
+
+                std::lock_guard lk(requests->api_mtx);
+                if (requests->api) requests->api->flushHistory();
+            });
+        }
+    }
+
+    void remember(std::span<const MessageView> views) {
+        std::vector<Message> msgs;
+        msgs.reserve(views.size());
+        for (auto& view : views) msgs.push_back(view.to_message());
+        remember(msgs);
+    }
+
+    void flushHistory() {
+        std::vector<Message> batch;
+        {
+            std::lock_guard lk(history_mtx);
+            batch.swap(history_pending);
+        }
+        try {
+            historyStore().store_history(batch);
+        } catch (const std::exception&) {}
+    }
+
+    // Chunked transfers of files and long texts, their messages are not shown.
+    // tick() runs every request timeout while something is being sent
+    Transfers transfers {
+        db, username,
+        [this](const std::string& peer, const std::string& text, bool bulk) {
+            return sendRaw(Message { 0, Datetime::now().toTime(), username, peer, text }.to_payload(), bulk ? Lane::Bulk : Lane::Control);
+        },
+        [this](const Message& notice) { deliver(notice); }
+    };
+    std::atomic_bool transfer_ticking = false;
+
+    void scheduleTransfers(std::chrono::milliseconds delay) {
+        if (transfer_ticking.exchange(true)) return;
+        executor->postAt(Async::Clock::now() + delay, [weak = std::weak_ptr(requests)] { transferTick(weak); });
+    }
+
+    static void transferTick(const std::weak_ptr<Requests>& weak) {
+        auto requests = weak.lock();
+        if (!requests) return;
+
+        std::lock_guard lk(requests->api_mtx);
+        auto api = requests->api;
+        if (!api) return;
+
+        // an ack crosses the server twice and waits for the peer, so give it two request timeouts
+        auto timeout = 2 * requests->rtt.timeout();
+        api->transfer_ticking = false;
+        if (api->transfers.tick(timeout)) api->scheduleTransfers(timeout);
+    }
+
+    // Incoming transfer messages are handled in arrival order on the executor: decoding chunks and
+    // saving a partial file must not hold up the reciever, which goes on with live messages and replies
+    std::deque<Message> bulk_inbox;
+    std::mutex bulk_mtx;
+    bool bulk_draining = false;
+
+    void dispatchBulk(Message message) {
+        {
+            std::lock_guard lk(bulk_mtx);
+            bulk_inbox.push_back(std::move(message));
+            if (bulk_draining) return;
+            bulk_draining = true;
+        }
+        executor->post([weak = std::weak_ptr(requests)] { drainBulk(weak); });
+    }
+
+    // Handles what has arrived so far, then yields the executor if more came meanwhile
+    static void drainBulk(const std::weak_ptr<Requests>& weak) {
+        auto requests = weak.lock();
+        if (!requests) return;
+
+        std::lock_guard lk(requests->api_mtx);
+        auto api = requests->api;
+        if (!api) return;
+
+        std::deque<Message> batch;
+        {
+            std::lock_guard bulk_lk(api->bulk_mtx);
+            batch.swap(api->bulk_inbox);
+        }
+        for (auto& msg : batch) api->deliver(msg);
+        {
+            std::lock_guard bulk_lk(api->bulk_mtx);
+            if (api->bulk_inbox.empty()) {
+                api->bulk_draining = false;
+                return;
+            }
+        }
+        api->executor->post([weak] { drainBulk(weak); });
+    }
+
+    void deliver(const Message& message) {
+        if (Transfers::isTransfer(message)) {
+            transfers.handle(message);
+            return;
+        }
+        PULSAR_TRACE_SCOPE("deliver", message.get_dst());
+        remember({ message });
+        std::lock_guard lk(handler_mtx);
+        if (message_handler) message_handler(message);
+        else std::cout << message << std::endl;
+    }
 public:
     enum LoginResult {
         Success,
@@ -35,67 +754,235 @@ public:
         Fail_Unknown
     };
 
-    PulsarAPI(std::shared_ptr<sf::TcpSocket> socket, const std::string& username)
-     : socket(socket), username(username), db(username) {
+    /// Coroutines of the *Async methods are resumed on `executor`
+    PulsarAPI(std::shared_ptr<sf::TcpSocket> socket, const std::string& username, Async::Executor& executor = Async::Executor::shared())
+     : socket(socket), username(username), db(username), executor(&executor) {
         if (!Checker::checkUsername(username)) PULSAR_THROW UsernameFailed(username);
+        requests->api = this;
+        seen_ids.restore(db.get_last_seen());
+
+        // Bridges ingesting every channel: an append-only log instead of SQLite inserts, at the cost of !search
+        if (const char* dir = std::getenv("PULSAR_HISTORY_LOG")) log = std::make_unique<MessageLog>(std::filesystem::path(dir) / username, username);
+
+        executor.postAt(Async::Clock::now() + std::chrono::milliseconds(PULSAR_PING_INTERVAL_MS), [weak = std::weak_ptr(requests)] {
+            keepalive(weak);
+        });
+    }
+
+    ~PulsarAPI() {
+        {
+            std::lock_guard lk(requests->api_mtx);
+            requests->api = nullptr;
+        }
+        {
+            std::lock_guard lk(link_mtx);
+            closing = true;
+            shutdownSocket();
+        }
+        link_cv.notify_all();
+        {
+            std::lock_guard lk(outbox_mtx);
+            connected = false;
+            setOutboxBytes(0);
+        }
+        outbox_cv.notify_all();
+        if (send_thr.joinable()) send_thr.join();
+        failPending();
+        stopReciever();
+        saveSeen();
+        flushHistory();
     }
 
     std::shared_ptr<sf::TcpSocket> getSocket() { return socket; }
 
-    bool connect(const std::string& ip, unsigned short port) {
-        if (!socket) socket = std::make_shared<sf::TcpSocket>();
+    /// Resolves `host` and connects `socket` to it. Needs no PulsarAPI, so the
+    /// connection can be opened while the database is still loading (see attach())
+    static bool dial(sf::TcpSocket& socket, const std::string& host, unsigned short port) {
+        std::optional<sf::IpAddress> address;
+        {
+            PULSAR_TRACE_SCOPE("resolve", host);
+            address = sf::IpAddress::resolve(host);
+        }
+        if (!address) return false;
+
+        PULSAR_TRACE_SCOPE("connect", address->toString());
+        return socket.connect(*address, port, sf::milliseconds(PULSAR_TIMEOUT_MS)) == sf::Socket::Status::Done;
+    }
+
+    /// Takes over a socket already connected to `ip`:`port`, the same as connect() without the dialing.
+    /// Reconnects go to `ip` again.
+    bool attach(std::shared_ptr<sf::TcpSocket> connected_socket, const std::string& ip, unsigned short port) {
+        if (send_thr.joinable()) send_thr.join();
+
+        std::lock_guard lk(link_mtx);
+        if (connected || !connected_socket) return false;
+
+        socket = std::move(connected_socket);
+        host = ip;
+        this->port = port;
+        closing = false;
 
-        sf::Socket::Status status = socket->connect(*sf::IpAddress::resolve(ip), port, sf::milliseconds(PULSAR_TIMEOUT_MS));
+        connected = true;
+        send_thr = std::thread { &PulsarAPI::senderLoop, this };
+        return true;
+    }
+
+    bool connect(const std::string& ip, unsigned short port) {
+        host = ip;
+        this->port = port;
+        closing = false;
 
-        if (status != sf::Socket::Status::Done) {
+        if (!openLink()) {
             std::cout << "Невозможно подключиться к " << ip << ":" << port << std::endl;
             std::cout << "Удостоверьтесь, что сервер работает и доступен." << std::endl;
             return false;
         }
 
         std::cout << "Conneted to " << ip << ":" << port << std::endl;
-        connected = true;
         return true;
     }
 
     void disconnect() {
-        socket->disconnect();
-        connected = false;
+        {
+            std::lock_guard lk(link_mtx);
+            closing = true;
+            shutdownSocket();
+        }
+        link_cv.notify_all();
+        {
+            std::lock_guard lk(outbox_mtx);
+            connected = false;
+            outbox.clear();
+            outbox_bulk.clear();
+            outbox_bulk_bytes = 0;
+            setOutboxBytes(0);
+        }
+        outbox_cv.notify_all();
+        drained_cv.notify_all();
+
+        if (send_thr.joinable() && send_thr.get_id() != std::this_thread::get_id()) send_thr.join();
+        failPending();
+        stopReciever();
+        {
+            std::lock_guard lk(link_mtx);
+            socket->disconnect();
+        }
+        saveSeen();
+        flushHistory();
         std::cout << "Отключено от сервера." << std::endl;
     }
 
     bool isConnected() { return connected; }
 
-    void sendRaw(const std::string& raw) {
-        if (!connected) return;
-        if (socket->send(raw.data(), raw.size()) != sf::Socket::Status::Done) {
-            std::cout << "Не удалось отправить сообщение" << std::endl;
-            disconnect();
+    /// The link is down and the reciever is trying to restore it
+    bool isReconnecting() { return !connected && auto_reconnect && !closing; }
+
+    /// When enabled, a dropped connection is restored in the background: the API reconnects with
+    /// backoff, logs in with the last successful password, sends messages typed offline and fetches
+    /// the ones it missed (see resumeAsync). Enable after login.
+    void setAutoReconnect(bool enable) { auto_reconnect = enable; }
+
+    /// Queues the payload for the sender thread and returns immediately.
+    /// Bulk frames are written PULSAR_BULK_BURST at a time between control ones.
+    /// @return false if not connected or more than PULSAR_SEND_QUEUE_BYTES (PULSAR_SEND_QUEUE_BULK_BYTES of bulk frames) are already waiting
+    bool sendRaw(std::string raw, Lane lane = Lane::Control) {
+        bool was_empty;
+        {
+            std::lock_guard lk(outbox_mtx);
+            if (!connected || outbox_bytes + raw.size() > PULSAR_SEND_QUEUE_BYTES) return false;
+            if (lane == Lane::Bulk && outbox_bulk_bytes + raw.size() > PULSAR_SEND_QUEUE_BULK_BYTES) return false;
+            setOutboxBytes(outbox_bytes + raw.size());
+            was_empty = outbox.empty() && outbox_bulk.empty();
+            if (lane == Lane::Bulk) {
+                outbox_bulk_bytes += raw.size();
+                outbox_bulk.push_back(std::move(raw));
+            } else {
+                outbox.push_back(std::move(raw));
+            }
         }
+        if (was_empty) outbox_cv.notify_one();    // the sender only sleeps on an empty queue
+        return true;
     }
 
-    void send(const Message& msg) {
-        sendRaw(msg.to_payload());
+    /// While reconnecting the message is kept in the database outbox and sent after the resume
+    bool send(const Message& msg) {
+        std::lock_guard lk(offline_mtx);
+        if (!offline) {
+            if (sendRaw(msg.to_payload())) {
+                stats().messages_sent.inc();
+                return true;
+            }
+            if (connected || !auto_reconnect || closing) return false;
+        }
+        db.queue_outgoing(msg);
+        stats().messages_offline.inc();
+        return true;
     }
 
-    void send(const std::string& message, const std::string& dest) {
-        send(Message {
+    bool send(const std::string& message, const std::string& dest) {
+        return send(Message {
             0, Datetime::now().toTime(),
             username, dest, message
         });
     }
 
-    std::string recvRaw() {
-        if (!connected) return {};
+    /// Waits until everything queued so far has been written to the socket
+    /// @return false if disconnected before that
+    bool flush() {
+        std::unique_lock lk(outbox_mtx);
+        drained_cv.wait(lk, [this] { return outbox_bytes == 0 || !connected; });
+        return connected;
+    }
 
+    bool recvMore(std::string& into) {
         char buffer[PULSAR_PACKET_SIZE];
         size_t recieved;
         if (socket->receive(buffer, sizeof(buffer), recieved) != sf::Socket::Status::Done) {
-            std::cout << "Не удалось получить сообщение" << std::endl;
-            disconnect();
+            if (!closing && !auto_reconnect) std::cout << "Не удалось получить сообщение" << std::endl;
+            recv_rest.clear();
+            linkDown();
+            return false;
         }
 
-        return std::string { buffer, recieved };
+        stats().bytes_received.inc(recieved);
+        into.append(buffer, recieved);
+        return true;
+    }
+
+    // Length of the payload at the start of `payload` when it is known: that of a transfer message,
+    // or of a server reply carrying one (a "!msg" fetch of a stored chunk is longer than a packet). Otherwise 0
+    static size_t payloadLength(std::string_view payload) {
+        if (size_t length = Transfers::frameLength(payload)) return length;
+
+        MessageView reply;
+        if (!Message::parse(payload, reply) || reply.src != serverSender()) return 0;
+        auto rsp = reply.msg.find("\x1eRSP:");
+        if (rsp == std::string_view::npos) return 0;
+        auto before = payload.size() - reply.msg.size() + rsp + 5;
+        if (size_t length = Transfers::frameLength(payload.substr(before))) return before + length;
+        return 0;
+    }
+
+    // One payload per call. Transfer messages carry their length, so when several of them
+    // arrive glued together (chunks are sent back to back) they are split here
+    std::string recvRaw() {
+        if (!connected) {
+            recv_rest.clear();
+            return {};
+        }
+
+        std::string payload = std::move(recv_rest);
+        recv_rest.clear();
+        if (payload.empty() && !recvMore(payload)) return {};
+        while (payloadLength(payload) > payload.size()) {
+            if (!recvMore(payload)) return {};
+        }
+
+        if (size_t length = payloadLength(payload); length && length < payload.size()) {
+            recv_rest = payload.substr(length);
+            payload.resize(length);
+        }
+        return payload;
     }
 
     Message recv() {
@@ -103,27 +990,60 @@ public:
     }
 
     void recieverLoop() {
-        while (connected) {
-            auto message = recv();
+        PULSAR_TRACE_THREAD("reciever");
+        while (true) {
+            while (connected) {
+                Message message;
+                try {
+                    message = recv();
+                } catch (const std::exception&) {
+                    continue;   // not a whole payload (the connection dropped or two payloads arrived glued together)
+                }
 
-            if (message.get_src() == "!server.msg") {
-                storeResponse(parseServer(message.get_msg()));
-            }
+                last_recv = Async::Clock::now();
+                requests->missed = 0;
 
-            else {
-                std::cout << message << std::endl;
+                if (message.get_src_symbol() == serverSender()) {
+                    storeResponse(parseServer(message.get_msg()));
+                }
+
+                else {
+                    stats().messages_received.inc();
+                    if (!noteSeen(message)) {
+                        stats().duplicates.inc();
+                        continue;
+                    }
+                    if (Transfers::isTransfer(message)) dispatchBulk(std::move(message));
+                    else deliver(message);
+                }
             }
 
-            sf::sleep(sf::milliseconds(20));
+            if (closing || !auto_reconnect || !relink()) break;
         }
+
+        if (!closing && !auto_reconnect) std::cout << "Отключено от сервера." << std::endl;
+    }
+
+    /// Called from the reciever thread for every incoming chat message.
+    /// Pass nullptr to print messages to std::cout (default).
+    /// After this returns the previous handler will not be called anymore.
+    void setMessageHandler(std::function<void(const Message&)> handler) {
+        std::lock_guard lk(handler_mtx);
+        message_handler = std::move(handler);
     }
 
     void startRecieverLoop() {
+        if (recv_thr.joinable()) recv_thr.join();
         recv_thr = std::thread { &PulsarAPI::recieverLoop, this };
-        recv_thr.detach();
     }
 
-    ServerResponse parseServer(const std::string& message) {
+    /// Sender of the server's replies, compared against every incoming message
+    static Symbol serverSender() {
+        static const Symbol sender { "!server.msg" };
+        return sender;
+    }
+
+    static ServerResponse parseServer(const std::string& message) {
         #ifdef PULSAR_DEBUG
             std::cout << "Server message:\n\traw: \"" << message << "\"\n\tparsed: ";
         #endif
@@ -172,158 +1092,233 @@ public:
         return res;
     }
 
+    /// Completes the oldest pending request with the same REQ text, replies nobody waits for are dropped
     void storeResponse(const ServerResponse& resp) {
-        std::lock_guard lk(responses_mtx);
-
-        responses.push_front(resp);
-
-        if (responses.size() > PULSAR_MAX_RESPONSES) responses.pop_back();
+        PULSAR_TRACE_SCOPE("response", resp.req.substr(0, resp.req.find(' ')));
+        std::coroutine_handle<> handle;
+        {
+            std::lock_guard lk(requests->mtx);
+            auto i = std::find_if(requests->list.begin(), requests->list.end(), [&](auto& p) { return p.sent && p.req == resp.req; });
+            if (i == requests->list.end()) return;
+
+            requests->rtt.sample(Async::Clock::now() - i->sent_at);
+            if (i->result) *i->result = resp.rsp;
+            handle = takeRequest(i);
+        }
+        pumpRequests();
+        if (handle) executor->post([handle] { handle.resume(); });
     }
 
-    std::string requestRaw(const std::string& req) {
-        if (!connected) return {};
-
-        send(req, "!server.req");
+    /// Smoothed RTT, its variation and the current request timeout
+    RttEstimator::Snapshot getRtt() { return requests->rtt.snapshot(); }
 
-        sf::Clock clk;
+    /// Sends `req` to the server and completes with the response, or an empty string
+    /// if no reply came within the RTT-based timeout (PULSAR_TIMEOUT_MS before the first reply)
+    Async::Task<std::string> requestRawAsync(std::string req) {
+        if (!connected) co_return std::string {};
 
-        while (clk.getElapsedTime().asMilliseconds() < PULSAR_TIMEOUT_MS) {
-            {
-                std::lock_guard lk(responses_mtx);
-    
-                for (auto i = responses.begin(); i != responses.end(); i++) {
-                    if (i->req == req) {
-                        auto ans = i->rsp;
-                        responses.erase(i);
-                        return ans;
-                    }
-                }
-            }
-
-            sf::sleep(sf::milliseconds(20));
-        }
-
-        return {};
+        PULSAR_TRACE_ASYNC("request", std::string_view(req).substr(0, req.find(' ')));
+        auto& latency = requestLatency(req);
+        auto start = Metrics::Clock::now();
+        auto response = co_await RequestAwaiter { *this, std::move(req) };
+        latency.record(Metrics::Clock::now() - start);
+        co_return response;
     }
 
     template<class... Args>
-    std::string request(const std::string& req_command, Args&&... args) {
+    Async::Task<std::string> requestAsync(const std::string& req_command, Args&&... args) {
         std::ostringstream oss;
         oss << '!' << req_command;
         ((oss << ' ' << std::forward<Args>(args)), ...);
 
-        return requestRaw(oss.str());
+        return requestRawAsync(oss.str());
     }
 
-    std::string request(const std::string& req_command) {
-        return requestRaw("!" + req_command);
+    std::string requestRaw(const std::string& req) {
+        return Async::syncWait(requestRawAsync(req), *executor);
+    }
+
+    template<class... Args>
+    std::string request(const std::string& req_command, Args&&... args) {
+        return Async::syncWait(requestAsync(req_command, std::forward<Args>(args)...), *executor);
     }
 
     /// Common API
+    ///
+    /// Every request has a coroutine version, `co_await api.getChatAsync(":all", 50)`, and a blocking
+    /// wrapper with the old name. Arguments of the *Async methods are taken by value because the task
+    /// may start after the caller's temporaries are gone.
+
+    Async::Task<void> sendRsaKeyAsync(PulsarCrypto::Asymmetrical::RSA::key pub) {
+        co_await requestAsync("rsa", pub.n, pub.s);
+    }
 
     void sendRsaKey(PulsarCrypto::Asymmetrical::RSA::key pub) {
-        auto response = request("rsa", pub.n, pub.s);
+        Async::syncWait(sendRsaKeyAsync(pub), *executor);
     }
 
-    bool joinChannel(const std::string& channel) {
-        auto response = request("join", channel);
+    Async::Task<bool> joinChannelAsync(std::string channel) {
+        auto response = co_await requestAsync("join", channel);
 
         if (response == "+") {
             db.join(channel);
-            return true;
+            co_return true;
         } else {
-            return false;
+            co_return false;
         }
     }
 
-    bool leaveChannel(const std::string& channel) {
-        auto response = request("leave", channel);
+    bool joinChannel(const std::string& channel) {
+        return Async::syncWait(joinChannelAsync(channel), *executor);
+    }
+
+    Async::Task<bool> leaveChannelAsync(std::string channel) {
+        auto response = co_await requestAsync("leave", channel);
 
         if (response == "+") {
             db.leave(channel);
-            return true;
+            co_return true;
         } else {
-            return false;
+            co_return false;
         }
     }
 
-    bool createChannel(const std::string& channel) {
+    bool leaveChannel(const std::string& channel) {
+        return Async::syncWait(leaveChannelAsync(channel), *executor);
+    }
+
+    Async::Task<bool> createChannelAsync(std::string channel) {
         if (!Checker::checkChannelName(channel)) PULSAR_THROW ChannelNameFailed(channel);
 
-        auto response = request("create", channel);
+        auto response = co_await requestAsync("create", channel);
 
         if (response == "+") {
-            joinChannel(channel);
-            return true;
+            co_await joinChannelAsync(channel);
+            co_return true;
         } else {
-            return false;
+            co_return false;
         }
     }
 
-    LoginResult login(const std::string& password) {
-        auto response = request("login", username, password);
+    bool createChannel(const std::string& channel) {
+        return Async::syncWait(createChannelAsync(channel), *executor);
+    }
+
+    Async::Task<LoginResult> loginAsync(std::string password) {
+        auto response = co_await requestAsync("login", username, password);
 
         if (response == "success") {
-            return LoginResult::Success;
+            {
+                std::lock_guard lk(link_mtx);
+                session_password = password;
+            }
+            co_return LoginResult::Success;
         } else if (response == "fail_username") {
-            return LoginResult::Fail_Username;
+            co_return LoginResult::Fail_Username;
         } else if (response == "fail_password") {
-            return LoginResult::Fail_Password;
+            co_return LoginResult::Fail_Password;
         } else {
-            return LoginResult::Fail_Unknown;
+            co_return LoginResult::Fail_Unknown;
         }
     }
 
-    LoginResult registerUser(const std::string& password) {
-        auto response = request("register", username, password);
+    LoginResult login(const std::string& password) {
+        PULSAR_TRACE_SCOPE("login");
+        return Async::syncWait(loginAsync(password), *executor);
+    }
+
+    Async::Task<LoginResult> registerUserAsync(std::string password) {
+        auto response = co_await requestAsync("register", username, password);
 
         if (response == "success") {
-            return LoginResult::Success;
+            {
+                std::lock_guard lk(link_mtx);
+                session_password = password;
+            }
+            co_return LoginResult::Success;
         } else if (response == "fail_username") {
-            return LoginResult::Fail_Username;
+            co_return LoginResult::Fail_Username;
         } else {
-            return LoginResult::Fail_Unknown;
+            co_return LoginResult::Fail_Unknown;
         }
     }
 
+    LoginResult registerUser(const std::string& password) {
+        return Async::syncWait(registerUserAsync(password), *executor);
+    }
+
+    Async::Task<Profile> getProfileAsync(std::string username) {
+        auto response = co_await requestAsync("profile", "get", username);
+
+        co_return Profile::from_payload(response);
+    }
+
     Profile getProfile(const std::string& username) {
-        auto response = request("profile", "get", username);
+        return Async::syncWait(getProfileAsync(username), *executor);
+    }
 
-        return Profile::from_payload(response);
+    /// Requests all profiles at once
+    Async::Task<std::vector<Profile>> getProfilesAsync(std::vector<std::string> usernames) {
+        std::vector<Async::Task<Profile>> tasks;
+        for (auto& name : usernames) tasks.push_back(getProfileAsync(name));
+
+        co_return co_await Async::whenAll(std::move(tasks));
     }
 
-    bool updateProfile(const Profile& profile) {
-        auto response = request("profile", "set", profile.to_payload());
+    std::vector<Profile> getProfiles(const std::vector<std::string>& usernames) {
+        return Async::syncWait(getProfilesAsync(usernames), *executor);
+    }
 
-        return response == "+";
+    Async::Task<bool> updateProfileAsync(Profile profile) {
+        auto response = co_await requestAsync("profile", "set", profile.to_payload());
+
+        co_return response == "+";
     }
 
-    bool createContact(const std::string& username, const std::string& contact) {
+    bool updateProfile(const Profile& profile) {
+        return Async::syncWait(updateProfileAsync(profile), *executor);
+    }
+
+    Async::Task<bool> createContactAsync(std::string username, std::string contact) {
         if (!Checker::checkUsername(username)) PULSAR_THROW UsernameFailed(username);
 
-        auto response = request("contact", "add", username, contact);
+        auto response = co_await requestAsync("contact", "add", username, contact);
 
         if (response == "+") {
             db.add_contact(username, contact);
-            return true;
-        } else return false;
+            co_return true;
+        } else co_return false;
     }
 
-    bool removeContact(const std::string& contact) {
+    bool createContact(const std::string& username, const std::string& contact) {
+        return Async::syncWait(createContactAsync(username, contact), *executor);
+    }
+
+    Async::Task<bool> removeContactAsync(std::string contact) {
         if (!Checker::checkUsername(contact)) PULSAR_THROW UsernameFailed(contact);
 
-        auto response = request("contact", "rem", contact);
+        auto response = co_await requestAsync("contact", "rem", contact);
         if (response == "+") {
             db.remove_contact(contact);
-            return true;
-        } else return false;
+            co_return true;
+        } else co_return false;
     }
 
-    Chat getChat(const std::string& chat, int lines_count = 50) {
+    bool removeContact(const std::string& contact) {
+        return Async::syncWait(removeContactAsync(contact), *executor);
+    }
+
+    Async::Task<Chat> getChatAsync(std::string chat, int lines_count = 50) {
         if (!Checker::checkChannelName(chat) && chat[0] != '@') PULSAR_THROW ChannelNameFailed(chat);
 
-        auto response = request("chat", chat, lines_count);
-        return Chat { chat, split(response, PULSAR_SEP) };
+        auto response = co_await requestAsync("chat", chat, lines_count);
+        Chat res { chat, std::move(response) };
+        remember(res.getMessages());
+        co_return res;
+    }
+
+    Chat getChat(const std::string& chat, int lines_count = 50) {
+        return Async::syncWait(getChatAsync(chat, lines_count), *executor);
     }
 
     bool isChannelMember(const std::string& channel) {
@@ -332,45 +1327,156 @@ public:
         return db.is_channel_member(channel);
     }
 
-    Message getMessageById(const std::string chat, size_t id) {
-        auto response = request("msg", chat, id);
+    Async::Task<Message> getMessageByIdAsync(std::string chat, size_t id) {
+        auto response = co_await requestAsync("msg", chat, id);
 
         auto msg = Message::from_payload(response);
 
-        return Message { id, msg.get_time().toTime(), msg.get_src(), chat, msg.get_msg() };
+        co_return Message { id, msg.get_time().toTime(), msg.get_src_symbol(), Symbol(chat), msg.get_msg() };
+    }
+
+    Message getMessageById(const std::string chat, size_t id) {
+        return Async::syncWait(getMessageByIdAsync(chat, id), *executor);
     }
 
     std::vector<Message> getUnread() {
         return db.get_unread();
     }
 
-    bool read(const std::string& chat, size_t id) {
+    /// Loads the bodies of one chat's unread messages, the counters below do not touch the database
+    std::vector<Message> getUnread(const std::string& chat) {
+        return db.get_unread(chat);
+    }
+
+    size_t getUnreadCount(const std::string& chat) {
+        return db.unread_count(chat);
+    }
+
+    size_t getUnreadCount() {
+        return db.unread_count();
+    }
+
+    std::map<std::string, size_t> getUnreadCounts() {
+        return db.unread_by_chat();
+    }
+
+    /// Kept messages of `chat`, no request to the server: the newest `limit` with ids below `before`, oldest first
+    std::vector<Message> getHistory(const std::string& chat, size_t before = std::numeric_limits<size_t>::max(), size_t limit = 50) {
+        flushHistory();
+        return historyStore().history(chat, before, limit);
+    }
+
+    /// Sends a file to `user` in chunks of PULSAR_TRANSFER_CHUNK bytes, reading it through a mapping.
+    /// Sending the same unchanged file again resumes a transfer that was cut short.
+    /// Throws std::runtime_error if the file cannot be read. @return transfer id
+    std::string sendFile(const std::string& user, const std::filesystem::path& path) {
+        auto id = transfers.sendFile(user, path);
+        scheduleTransfers(2 * requests->rtt.timeout());
+        return id;
+    }
+
+    /// Sends a message longer than PULSAR_MSG_SIZE to `user` as a transfer, it arrives whole
+    std::string sendLong(const std::string& user, std::string text) {
+        auto id = transfers.sendText(user, std::move(text));
+        scheduleTransfers(2 * requests->rtt.timeout());
+        return id;
+    }
+
+    std::vector<Transfers::Progress> getTransfers() { return transfers.list(); }
+
+    /// Full-text search over messages this client has seen, no request to the server.
+    /// Every word must match, `word*` matches a prefix; best matches first. Not available with PULSAR_HISTORY_LOG.
+    std::vector<Message> search(const std::string& text, const std::string& chat = "", size_t limit = 20, size_t offset = 0) {
+        flushHistory();
+        return db.search(text, chat, limit, offset);
+    }
+
+    Async::Task<bool> readAsync(std::string chat, size_t id) {
         db.read(chat, id);
-        return request("read", chat, id) == "+";
+        co_return co_await requestAsync("read", chat, id) == "+";
     }
 
-    void readAll(const std::string& chat) {
-        for (auto i : getUnread()) {
-            if (chat == i.get_dst()) read(chat, i.get_id());
+    bool read(const std::string& chat, size_t id) {
+        return Async::syncWait(readAsync(chat, id), *executor);
+    }
+
+    /// Marks every message in `chat` up to and including `id` as read with a single `!readupto`.
+    /// A server without it answers something else; then the ids known locally go out as `!read` one by one.
+    Async::Task<bool> readUpToAsync(std::string chat, size_t id) {
+        auto ids = db.unread_ids(chat, id);
+        db.read_up_to(chat, id);
+
+        if (readupto_supported) {
+            auto response = co_await requestAsync("readupto", chat, id);
+            if (response == "+") co_return true;
+            if (!connected) co_return false;
+            if (!response.empty()) readupto_supported = false;     // an empty one is a timeout, try again next time
         }
+
+        bool ok = true;
+        for (auto i : ids) ok = co_await requestAsync("read", chat, i) == "+" && ok;
+        co_return ok;
+    }
+
+    bool readUpTo(const std::string& chat, size_t id) {
+        return Async::syncWait(readUpToAsync(chat, id), *executor);
+    }
+
+    Async::Task<void> readAllAsync(std::string chat) {
+        auto chats = db.unread_chats();
+        auto newest = chats.find(chat);
+        if (newest != chats.end()) co_await readUpToAsync(chat, newest->second);
+    }
+
+    void readAll(const std::string& chat) {
+        Async::syncWait(readAllAsync(chat), *executor);
+    }
+
+    /// One `!readupto` per chat with unread messages
+    Async::Task<void> readAllAsync() {
+        std::vector<Async::Task<bool>> tasks;
+        for (auto& [chat, newest] : db.unread_chats()) tasks.push_back(readUpToAsync(chat, newest));
+        co_await Async::whenAll(std::move(tasks));
     }
 
     void readAll() {
-        for (auto i : getUnread()) read(i.get_dst(), i.get_id());
+        Async::syncWait(readAllAsync(), *executor);
     }
 
-    void requestUnread() {
-        auto response = request("getUnread");
-        
-        auto splited = split(response, ';');
+    /// Fetches every unread message concurrently and stores them in the database
+    Async::Task<void> requestUnreadAsync() {
+        PULSAR_TRACE_ASYNC("unread");
+        auto response = co_await requestAsync("getUnread");
 
-        for (auto unread : splited) {
-            auto chat = split(unread, '|')[0];
-            auto id = std::stoull(split(unread, '|')[1]);
+        std::vector<Async::Task<Message>> tasks;
+        for (auto unread : Tokenizer(response, ';')) {
+            auto bar = unread.find('|');
+            if (bar == std::string_view::npos) continue;
 
-            auto msg = getMessageById(chat, id);
+            std::string chat { unread.substr(0, bar) };
+            auto id = std::stoull(std::string(unread.substr(bar + 1)));
 
-            db.store_unread(msg);
+            tasks.push_back(getMessageByIdAsync(chat, id));
         }
+
+        auto msgs = co_await Async::whenAll(std::move(tasks));
+        std::erase_if(msgs, [this](const Message& msg) {
+            bool fresh = noteSeen(msg);
+            if (Transfers::isTransfer(msg)) {
+                if (fresh) transfers.handle(msg);      // an offer made while we were offline
+                return true;
+            }
+
+            // Unread even if the live loop got it during the sync, that only keeps it out of the history a second time
+            db.store_unread(msg);
+            if (!fresh) stats().duplicates.inc();
+            return !fresh;
+        });
+        remember(msgs);
+    }
+
+    void requestUnread() {
+        PULSAR_TRACE_SCOPE("requestUnread");
+        Async::syncWait(requestUnreadAsync(), *executor);
     }
 };
\ No newline at end of file
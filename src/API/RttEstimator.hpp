@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../defines"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+
+// Smoothed round-trip time of server requests and the timeout derived from it, as TCP does (RFC 6298):
+// SRTT and RTTVAR follow every reply, RTO = SRTT + 4 * RTTVAR, doubled after a timeout until the next reply.
+class RttEstimator {
+public:
+    using Duration = std::chrono::duration<double, std::milli>;
+
+    struct Snapshot {
+        bool measured;          // false until the first reply
+        double srtt_ms;
+        double rttvar_ms;
+        double rto_ms;
+    };
+
+private:
+    mutable std::mutex mtx;
+    bool measured = false;
+    double srtt = 0, rttvar = 0;
+    double rto = PULSAR_TIMEOUT_MS;     // before the first sample
+
+    static double clamp(double ms) {
+        return std::clamp(ms, (double)PULSAR_RTO_MIN_MS, (double)PULSAR_RTO_MAX_MS);
+    }
+
+public:
+    void sample(Duration rtt) {
+        double r = rtt.count();
+        std::lock_guard lk(mtx);
+
+        if (!measured) {
+            srtt = r;
+            rttvar = r / 2;
+            measured = true;
+        } else {
+            rttvar = 0.75 * rttvar + 0.25 * std::abs(srtt - r);
+            srtt = 0.875 * srtt + 0.125 * r;
+        }
+        rto = clamp(srtt + 4 * rttvar);
+    }
+
+    /// A request went unanswered: wait twice as long for the next ones
+    void backoff() {
+        std::lock_guard lk(mtx);
+        rto = clamp(rto * 2);
+    }
+
+    std::chrono::milliseconds timeout() const {
+        std::lock_guard lk(mtx);
+        return std::chrono::milliseconds((int64_t)std::ceil(rto));
+    }
+
+    Snapshot snapshot() const {
+        std::lock_guard lk(mtx);
+        return { measured, srtt, rttvar, rto };
+    }
+};
@@ -0,0 +1,398 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+
+#include "PulsarAPI.hpp"
+#include "../Network/Poller.hpp"
+
+// Drives many headless Pulsar sessions from a small fixed pool of event loops
+// (one Poller and one thread per loop) instead of a socket + thread + database per PulsarAPI.
+//
+// Every session is a small state machine: LoggingIn -> Ready, or -> Failed/Closed.
+// Server replies are matched to pending requests by their REQ text, like PulsarAPI::requestRaw does,
+// but without blocking: the response handler is called from the session's loop.
+//
+// Sessions keep no local database, incoming chat messages go to the message handler.
+// All handlers run on loop threads; with more than one loop they may run concurrently.
+class SessionEngine {
+public:
+    using SessionId = size_t;
+
+    static constexpr SessionId Invalid = (SessionId)-1;
+
+    enum State {
+        LoggingIn,
+        Ready,
+        Failed,     // login or registration rejected, the session is closed
+        Closed
+    };
+
+    using MessageHandler = std::function<void(SessionId, const Message&)>;
+    using StateHandler = std::function<void(SessionId, State)>;
+    using ResponseHandler = std::function<void(const std::string& rsp)>;   // empty string on timeout or disconnect
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingRequest {
+        std::string req;
+        uint64_t seq;
+        ResponseHandler handler;
+    };
+
+    struct Session {
+        SessionId id;
+        State state = LoggingIn;
+        std::string username;
+        PollableSocket socket;
+        std::vector<std::string> out;       // every payload goes out with its own send(), the protocol has no framing
+        size_t out_head = 0;
+        size_t out_pos = 0;
+        bool writing = false;
+        std::vector<PendingRequest> pending;
+        std::string password;               // released once logged in
+        bool register_missing = true;
+    };
+
+    struct Timeout {
+        Clock::time_point deadline;
+        SessionId id;
+        uint64_t seq;
+    };
+
+    struct Loop {
+        Poller poller;
+        std::thread thread;
+        std::unordered_map<SessionId, std::unique_ptr<Session>> sessions;
+        std::deque<Timeout> timeouts;
+        std::vector<SessionId> closed;
+        uint64_t seq = 0;
+
+        std::mutex mtx;
+        std::vector<std::unique_ptr<Session>> incoming;
+        std::vector<std::function<void(Loop&)>> commands;
+
+        char buffer[PULSAR_PACKET_SIZE];
+    };
+
+    std::vector<std::unique_ptr<Loop>> loops;
+    std::atomic<SessionId> next_id = 0;
+    std::atomic_bool running = true;
+    std::atomic<size_t> ready_count = 0;
+    std::atomic<size_t> open_count = 0;
+
+    MessageHandler message_handler;
+    StateHandler state_handler;
+
+    Loop& loopOf(SessionId id) { return *loops[id % loops.size()]; }
+
+    void post(SessionId id, std::function<void(Loop&)> command) {
+        auto& loop = loopOf(id);
+        bool was_empty;
+        {
+            std::lock_guard lk(loop.mtx);
+            was_empty = loop.commands.empty() && loop.incoming.empty();
+            loop.commands.push_back(std::move(command));
+        }
+        if (was_empty) loop.poller.wake();
+    }
+
+    static Session* find(Loop& loop, SessionId id) {
+        auto it = loop.sessions.find(id);
+        if (it == loop.sessions.end() || it->second->state >= Failed) return nullptr;
+        return it->second.get();
+    }
+
+    void setState(Session& s, State state) {
+        if (s.state == state) return;
+        if (s.state == Ready) ready_count--;
+        if (state == Ready) ready_count++;
+        s.state = state;
+        if (state_handler) state_handler(s.id, state);
+    }
+
+    void closeSession(Loop& loop, Session& s, State state = Closed) {
+        if (s.state >= Failed) return;
+
+        loop.poller.remove(s.socket.getNativeHandle());
+        s.socket.disconnect();
+        open_count--;
+
+        setState(s, state);
+        loop.closed.push_back(s.id);
+
+        auto pending = std::move(s.pending);
+        for (auto& p : pending) p.handler({});
+    }
+
+    // Returns false if the socket failed and the session was closed
+    bool flush(Loop& loop, Session& s) {
+        while (s.out_head < s.out.size()) {
+            auto& data = s.out[s.out_head];
+            size_t sent = 0;
+            auto status = s.socket.send(data.data() + s.out_pos, data.size() - s.out_pos, sent);
+            s.out_pos += sent;
+
+            if (status == sf::Socket::Status::Done) {
+                s.out_head++;
+                s.out_pos = 0;
+                continue;
+            }
+            if (status == sf::Socket::Status::Partial || status == sf::Socket::Status::NotReady) {
+                if (!s.writing) {
+                    loop.poller.modify(s.socket.getNativeHandle(), Poller::Read | Poller::Write, &s);
+                    s.writing = true;
+                }
+                return true;
+            }
+
+            closeSession(loop, s);
+            return false;
+        }
+
+        s.out.clear();
+        if (s.out.capacity() > 16) s.out.shrink_to_fit();
+        s.out_head = 0;
+        if (s.writing) {
+            loop.poller.modify(s.socket.getNativeHandle(), Poller::Read, &s);
+            s.writing = false;
+        }
+        return true;
+    }
+
+    void sendPayload(Loop& loop, Session& s, std::string payload) {
+        s.out.push_back(std::move(payload));
+        if (!s.writing) flush(loop, s);
+    }
+
+    void sendRequest(Loop& loop, Session& s, const std::string& req, ResponseHandler handler) {
+        auto seq = ++loop.seq;
+        s.pending.push_back({ req, seq, std::move(handler) });
+        loop.timeouts.push_back({ Clock::now() + std::chrono::milliseconds(PULSAR_TIMEOUT_MS), s.id, seq });
+
+        sendPayload(loop, s, Message { 0, Datetime::now().toTime(), s.username, "!server.req", req }.to_payload());
+    }
+
+    void loggedIn(Session& s) {
+        std::string().swap(s.password);
+        setState(s, Ready);
+    }
+
+    void login(Loop& loop, Session& s) {
+        auto id = s.id;
+
+        sendRequest(loop, s, "!login " + s.username + " " + s.password, [this, &loop, id](const std::string& rsp) {
+            auto s = find(loop, id);
+            if (!s) return;
+
+            if (rsp == "success") loggedIn(*s);
+            else if (rsp == "fail_username" && s->register_missing) {
+                sendRequest(loop, *s, "!register " + s->username + " " + s->password, [this, &loop, id](const std::string& rsp) {
+                    auto s = find(loop, id);
+                    if (!s) return;
+
+                    if (rsp == "success") loggedIn(*s);
+                    else closeSession(loop, *s, Failed);
+                });
+            }
+            else closeSession(loop, *s, Failed);
+        });
+    }
+
+    void handle(Session& s, std::string_view payload) {
+        Message msg;
+        try {
+            msg = Message::from_payload(payload);
+        } catch (const std::exception&) {
+            return;
+        }
+
+        if (msg.get_src_symbol() != PulsarAPI::serverSender()) {
+            if (message_handler) message_handler(s.id, msg);
+            return;
+        }
+
+        auto resp = PulsarAPI::parseServer(msg.get_msg());
+        for (auto i = s.pending.begin(); i != s.pending.end(); i++) {
+            if (i->req == resp.req) {
+                auto handler = std::move(i->handler);
+                s.pending.erase(i);
+                handler(resp.rsp);
+                return;
+            }
+        }
+    }
+
+    void readable(Loop& loop, Session& s) {
+        // A few receives per wakeup so one busy session cannot starve the others
+        for (int i = 0; i < 16 && s.state < Failed; i++) {
+            size_t received = 0;
+            auto status = s.socket.receive(loop.buffer, sizeof(loop.buffer), received);
+
+            if (status == sf::Socket::Status::Done) handle(s, { loop.buffer, received });
+            else if (status == sf::Socket::Status::NotReady) return;
+            else closeSession(loop, s);
+        }
+    }
+
+    void expire(Loop& loop) {
+        auto now = Clock::now();
+        while (!loop.timeouts.empty() && loop.timeouts.front().deadline <= now) {
+            auto t = loop.timeouts.front();
+            loop.timeouts.pop_front();
+
+            auto s = find(loop, t.id);
+            if (!s) continue;
+
+            for (auto i = s->pending.begin(); i != s->pending.end(); i++) {
+                if (i->seq == t.seq) {
+                    auto handler = std::move(i->handler);
+                    s->pending.erase(i);
+                    handler({});
+                    break;
+                }
+            }
+        }
+    }
+
+    void run(Loop& loop) {
+        std::vector<Poller::Event> events;
+        std::vector<std::unique_ptr<Session>> incoming;
+        std::vector<std::function<void(Loop&)>> commands;
+
+        while (running) {
+            int timeout = 100;
+            if (!loop.timeouts.empty()) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(loop.timeouts.front().deadline - Clock::now()).count() + 1;
+                timeout = (int)std::clamp<long long>(left, 0, timeout);
+            }
+
+            loop.poller.wait(events, timeout);
+
+            for (auto& ev : events) {
+                if (!ev.data) continue;
+                auto& s = *static_cast<Session*>(ev.data);
+
+                if (ev.events & (Poller::Read | Poller::Hangup)) readable(loop, s);
+                if ((ev.events & Poller::Write) && s.state < Failed) flush(loop, s);
+            }
+
+            {
+                std::lock_guard lk(loop.mtx);
+                incoming.swap(loop.incoming);
+                commands.swap(loop.commands);
+            }
+
+            for (auto& item : incoming) {
+                auto& s = *item;
+                loop.poller.add(s.socket.getNativeHandle(), Poller::Read, &s);
+                loop.sessions[s.id] = std::move(item);
+                if (state_handler) state_handler(s.id, LoggingIn);
+                login(loop, s);
+            }
+            incoming.clear();
+
+            for (auto& command : commands) command(loop);
+            commands.clear();
+
+            expire(loop);
+
+            for (auto id : loop.closed) loop.sessions.erase(id);
+            loop.closed.clear();
+        }
+
+        for (auto& [id, s] : loop.sessions) closeSession(loop, *s);
+        loop.sessions.clear();
+    }
+
+public:
+    SessionEngine(size_t loop_count = 1) {
+        if (loop_count == 0) loop_count = 1;
+        for (size_t i = 0; i < loop_count; i++) loops.push_back(std::make_unique<Loop>());
+        for (auto& loop : loops) loop->thread = std::thread { &SessionEngine::run, this, std::ref(*loop) };
+    }
+
+    ~SessionEngine() {
+        running = false;
+        for (auto& loop : loops) {
+            loop->poller.wake();
+            loop->thread.join();
+        }
+    }
+
+    SessionEngine(const SessionEngine&) = delete;
+    SessionEngine& operator=(const SessionEngine&) = delete;
+
+    /// Set both handlers before the first open()
+    void setMessageHandler(MessageHandler handler) { message_handler = std::move(handler); }
+    void setStateHandler(StateHandler handler) { state_handler = std::move(handler); }
+
+    /// Connects (blocking, on the calling thread) and hands the session to a loop,
+    /// which logs in and, if `register_missing`, registers unknown users.
+    /// @return Session id or Invalid if the server is unreachable
+    SessionId open(const std::string& ip, unsigned short port, const std::string& username, const std::string& password, bool register_missing = true) {
+        if (!Checker::checkUsername(username)) PULSAR_THROW UsernameFailed(username);
+
+        auto address = sf::IpAddress::resolve(ip);
+        if (!address) return Invalid;
+
+        // No connect timeout: SFML implements it with select(), which breaks past FD_SETSIZE descriptors
+        auto s = std::make_unique<Session>();
+        if (s->socket.connect(*address, port) != sf::Socket::Status::Done) return Invalid;
+        s->socket.setBlocking(false);
+
+        s->id = next_id++;
+        s->username = username;
+        s->password = password;
+        s->register_missing = register_missing;
+        open_count++;
+
+        auto id = s->id;
+        auto& loop = loopOf(id);
+        bool was_empty;
+        {
+            std::lock_guard lk(loop.mtx);
+            was_empty = loop.commands.empty() && loop.incoming.empty();
+            loop.incoming.push_back(std::move(s));
+        }
+        if (was_empty) loop.poller.wake();
+
+        return id;
+    }
+
+    /// Thread-safe. Dropped if the session is not Ready.
+    void send(SessionId id, const std::string& message, const std::string& dest) {
+        post(id, [this, id, message, dest](Loop& loop) {
+            auto s = find(loop, id);
+            if (!s || s->state != Ready) return;
+            sendPayload(loop, *s, Message { 0, Datetime::now().toTime(), s->username, dest, message }.to_payload());
+        });
+    }
+
+    /// Thread-safe. `req` is a full request, e.g. "!join :news".
+    void request(SessionId id, const std::string& req, ResponseHandler handler) {
+        post(id, [this, id, req, handler = std::move(handler)](Loop& loop) mutable {
+            auto s = find(loop, id);
+            if (!s) return handler({});
+            sendRequest(loop, *s, req, std::move(handler));
+        });
+    }
+
+    /// Thread-safe
+    void close(SessionId id) {
+        post(id, [this, id](Loop& loop) {
+            if (auto s = find(loop, id)) closeSession(loop, *s);
+        });
+    }
+
+    size_t openCount() const { return open_count; }
+    size_t readyCount() const { return ready_count; }
+    size_t loopCount() const { return loops.size(); }
+};
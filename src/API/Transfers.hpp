@@ -0,0 +1,640 @@
+#pragma once
+
+#include "../defines"
+#include "../lib/hash.h"
+#include "../Network/Database.hpp"
+#include "../Network/MappedFile.hpp"
+#include "../Other/Datetime.hpp"
+#include "../Other/Message.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Files and texts longer than one message, sent to a user as a stream of ordinary messages
+// that start with PULSAR_XFER and the length of the whole text in four digits; the server only relays them.
+// The length lets the receiver split transfer messages read glued together (see frameLength()). Then:
+//
+//   O <id> <F|T> <size> <chunk> <name>    offer of a file, or of a text shown as a message once complete
+//   A <id> <next> <bits>                  every chunk below `next` arrived, bit k of `bits` (hex) is chunk next+1+k
+//   C <id> <index> <sum> <base64>         chunk of `chunk` bytes (the last one shorter), `sum` is fnv1a of them
+//   E <id> <sum>                          every chunk is acknowledged, `sum` is fnv1a over the chunk sums
+//   D <id> +|-                            the receiver checked the sum and kept the file, or refused it
+//
+// A full chunk message is exactly PULSAR_PACKET_SIZE bytes long (it uses the reserved bytes), so a server
+// reading PULSAR_PACKET_SIZE bytes per message stays in step when chunks arrive back to back.
+// Up to PULSAR_TRANSFER_WINDOW chunks are unacknowledged at a time. The link keeps them in order, so a hole
+// before an acknowledged chunk means a lost one (a payload read glued to another is dropped) and it is sent
+// again right away; unacknowledged chunks are also repeated after a timeout (tick()).
+// A file's transfer id follows from the file, offering it again after a restart resumes the transfer:
+// the receiver keeps the chunks in a mapped .part file and which of them it has in the database.
+class Transfers {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Send = std::function<bool(const std::string& peer, const std::string& text, bool bulk)>;
+    using Notify = std::function<void(const Message&)>;
+
+    enum State {
+        Offered,        // waiting for the receiver to answer
+        Sending,
+        Finishing,      // every chunk acknowledged, waiting for the checksum verdict
+        Receiving,
+        Done,
+        Failed,
+        Paused          // the peer stopped answering, sending the file again resumes it
+    };
+
+    struct Progress {
+        std::string id, peer, name;
+        bool incoming;
+        State state;
+        size_t size, done;      // bytes
+    };
+
+private:
+    struct Outgoing {
+        std::string id, peer, name;
+        bool text;
+        State state = Offered;
+        std::unique_ptr<MappedFile> file;
+        std::shared_ptr<const FileMapping> mapping;
+        std::string body;                   // a text is sent from memory
+        size_t size = 0, chunks = 0;
+        std::vector<bool> acked;
+        std::vector<uint64_t> sent;         // transmission number of each chunk's last send, 0 if never sent
+        size_t base = 0, next = 0;          // first unacknowledged chunk, first one never looked at by pump()
+        size_t acked_count = 0;
+        uint64_t transmissions = 0;
+        unsigned retries = 0;
+        Clock::time_point last_progress = Clock::now();
+
+        const char* data() const { return text ? body.data() : mapping->data(); }
+    };
+
+    struct Incoming {
+        std::string id, peer, name;
+        bool text;
+        State state = Receiving;
+        std::filesystem::path part;
+        std::unique_ptr<MappedFile> file;
+        std::shared_ptr<FileMapping> mapping;
+        std::string body;
+        size_t size = 0, chunk = 0, chunks = 0;
+        std::vector<bool> have;
+        size_t next = 0;                    // first missing chunk
+        size_t received = 0, unsaved = 0, unacked = 0;
+
+        char* data() { return text ? body.data() : mapping->data(); }
+    };
+
+    Database& db;
+    std::string username;
+    std::filesystem::path dir;
+    Send send;
+    Notify notify;
+
+    std::mutex mtx;
+    std::map<std::string, std::unique_ptr<Outgoing>> outgoing;      // by id
+    std::map<std::string, std::unique_ptr<Incoming>> incoming;      // by peer and id
+    std::vector<Message> notices;                                   // delivered once mtx is released
+
+    static constexpr size_t header = PULSAR_ID_SIZE + PULSAR_TIME_SIZE + PULSAR_SRC_SIZE + PULSAR_DST_SIZE;
+    static constexpr size_t prefix = 5;     // marker and length
+
+    // prefix, "C ", id, index and sum with their spaces, then the base64
+    static_assert(header + prefix + 31 + PULSAR_TRANSFER_CHUNK / 3 * 4 <= PULSAR_PACKET_SIZE
+                  && PULSAR_TRANSFER_CHUNK % 3 == 0, "a chunk message has to fit in one packet");
+    static_assert(PULSAR_TRANSFER_WINDOW <= 64, "acks describe 64 chunks");
+
+    static size_t chunkCount(size_t size, size_t chunk) { return (size + chunk - 1) / chunk; }
+
+    static size_t chunkBytes(size_t size, size_t chunk, size_t i) { return std::min(chunk, size - i * chunk); }
+
+    static uint32_t chunkSum(const char* data, size_t size, size_t chunk, size_t i) {
+        return fnv1a(std::string_view(data + i * chunk, chunkBytes(size, chunk, i)));
+    }
+
+    // fnv1a over the little-endian sums of all chunks: both sides hash what they hold in one pass
+    static uint32_t totalSum(const char* data, size_t size, size_t chunk) {
+        std::string sums;
+        sums.reserve(chunkCount(size, chunk) * 4);
+        for (size_t i = 0; i < chunkCount(size, chunk); i++) {
+            uint32_t sum = chunkSum(data, size, chunk, i);
+            for (int b = 0; b < 4; b++) sums.push_back((char)(sum >> (8 * b)));
+        }
+        return fnv1a(sums);
+    }
+
+    static std::string hex(uint64_t value) {
+        char buf[16];
+        auto end = std::to_chars(buf, buf + sizeof(buf), value, 16).ptr;
+        return { buf, end };
+    }
+
+    // Zero-padded, so every full chunk message has the same length
+    static std::string fixed(uint64_t value, size_t width, int base = 10) {
+        char buf[20];
+        auto end = std::to_chars(buf, buf + sizeof(buf), value, base).ptr;
+        std::string out(width > size_t(end - buf) ? width - (end - buf) : 0, '0');
+        return out.append(buf, end);
+    }
+
+    template<class T>
+    static bool number(std::string_view field, T& out, int base = 10) {
+        auto end = field.data() + field.size();
+        auto [ptr, ec] = std::from_chars(field.data(), end, out, base);
+        return ec == std::errc {} && ptr == end;
+    }
+
+    // Ids are fixed(fnv1a(...), 8, 16); one from a peer also names the .part file, so nothing else is taken
+    static bool validId(std::string_view id) {
+        return id.size() == 8 && std::all_of(id.begin(), id.end(), [](char c) { return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'); });
+    }
+
+    // First `n - 1` space-separated fields and the rest of the text as the last one
+    static std::vector<std::string_view> fields(std::string_view text, size_t n) {
+        std::vector<std::string_view> out;
+        while (out.size() + 1 < n) {
+            auto space = text.find(' ');
+            if (space == std::string_view::npos) break;
+            out.push_back(text.substr(0, space));
+            text.remove_prefix(space + 1);
+        }
+        out.push_back(text);
+        return out;
+    }
+
+    static constexpr char base64_digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    static std::string base64(std::string_view bytes) {
+        std::string out;
+        out.reserve((bytes.size() + 2) / 3 * 4);
+        for (size_t i = 0; i < bytes.size(); i += 3) {
+            uint32_t n = (uint8_t)bytes[i] << 16;
+            if (i + 1 < bytes.size()) n |= (uint8_t)bytes[i + 1] << 8;
+            if (i + 2 < bytes.size()) n |= (uint8_t)bytes[i + 2];
+            out.push_back(base64_digits[n >> 18]);
+            out.push_back(base64_digits[(n >> 12) & 63]);
+            out.push_back(i + 1 < bytes.size() ? base64_digits[(n >> 6) & 63] : '=');
+            out.push_back(i + 2 < bytes.size() ? base64_digits[n & 63] : '=');
+        }
+        return out;
+    }
+
+    // Into `out`, which must hold the decoded bytes; returns how many there were, or -1 if `text` is not base64
+    static ptrdiff_t unbase64(std::string_view text, char* out, size_t capacity) {
+        if (text.size() % 4) return -1;
+        size_t n = 0;
+        for (size_t i = 0; i < text.size(); i += 4) {
+            uint32_t v = 0;
+            int pad = 0;
+            for (int k = 0; k < 4; k++) {
+                char c = text[i + k];
+                int d = c >= 'A' && c <= 'Z' ? c - 'A'
+                      : c >= 'a' && c <= 'z' ? c - 'a' + 26
+                      : c >= '0' && c <= '9' ? c - '0' + 52
+                      : c == '+' ? 62 : c == '/' ? 63 : -1;
+                if (c == '=' && i + 4 == text.size() && k >= 2) {
+                    pad++;
+                    d = 0;
+                }
+                else if (d < 0 || pad) return -1;
+                v = v << 6 | d;
+            }
+            if (n + 3 - pad > capacity) return -1;
+            out[n++] = (char)(v >> 16);
+            if (pad < 2) out[n++] = (char)(v >> 8);
+            if (pad < 1) out[n++] = (char)v;
+        }
+        return n;
+    }
+
+    // A received name is only ever a file name inside dir
+    static std::string safeName(std::string_view name) {
+        std::string out;
+        for (char c : name) {
+            if ((unsigned char)c < 0x20 || c == '/' || c == '\\' || c == ':') continue;
+            out.push_back(c);
+        }
+        if (out.empty() || out == "." || out == "..") return "file";
+        return out;
+    }
+
+    std::filesystem::path freePath(const std::string& name) const {
+        std::filesystem::path path = dir / name;
+        auto stem = path.stem().string(), ext = path.extension().string();
+        for (int i = 1; std::filesystem::exists(path); i++) path = dir / (stem + " (" + std::to_string(i) + ")" + ext);
+        return path;
+    }
+
+    bool transmit(const std::string& peer, const std::string& body, bool bulk = false) {
+        return send(peer, PULSAR_XFER + fixed(prefix + body.size(), prefix - 1) + body, bulk);
+    }
+
+    void tell(const std::string& peer, char type, const std::string& id, const std::string& rest) {
+        transmit(peer, type + (' ' + id) + ' ' + rest);
+    }
+
+    void notice(const std::string& peer, std::string text) {
+        notices.push_back(Message { 0, Datetime::now().toTime(), peer, username, std::move(text) });
+    }
+
+    void flushNotices() {
+        std::vector<Message> ready;
+        {
+            std::lock_guard lk(mtx);
+            ready.swap(notices);
+        }
+        for (auto& msg : ready) notify(msg);
+    }
+
+    // Sending
+
+    void offer(Outgoing& t) {
+        tell(t.peer, 'O', t.id, std::string(t.text ? "T " : "F ") + std::to_string(t.size) + ' ' + std::to_string(PULSAR_TRANSFER_CHUNK) + ' ' + t.name);
+    }
+
+    bool sendChunk(Outgoing& t, size_t i) {
+        std::string_view bytes(t.data() + i * PULSAR_TRANSFER_CHUNK, chunkBytes(t.size, PULSAR_TRANSFER_CHUNK, i));
+        if (!transmit(t.peer, "C " + t.id + ' ' + fixed(i, 10) + ' ' + fixed(fnv1a(bytes), 8, 16) + ' ' + base64(bytes), true)) return false;
+        t.sent[i] = ++t.transmissions;
+        return true;
+    }
+
+    void pump(Outgoing& t) {
+        while (t.next < t.chunks && t.next - t.base < PULSAR_TRANSFER_WINDOW) {
+            if (!t.acked[t.next] && !sendChunk(t, t.next)) return;     // the send queue is full, tick() goes on
+            t.next++;
+        }
+        if (t.base == t.chunks && t.state == Sending) {
+            t.state = Finishing;
+            tell(t.peer, 'E', t.id, hex(totalSum(t.data(), t.size, PULSAR_TRANSFER_CHUNK)));
+        }
+    }
+
+    void start(std::unique_ptr<Outgoing> t) {
+        t->chunks = chunkCount(t->size, PULSAR_TRANSFER_CHUNK);
+        t->acked.assign(t->chunks, false);
+        t->sent.assign(t->chunks, 0);
+
+        std::lock_guard lk(mtx);
+        offer(*t);
+        outgoing[t->id] = std::move(t);
+    }
+
+    void acknowledged(Outgoing& t, std::string_view next_field, std::string_view bits_field) {
+        size_t next;
+        uint64_t bits;
+        if (!number(next_field, next) || !number(bits_field, bits, 16) || next > t.chunks) return;
+        if (t.state == Offered) t.state = Sending;
+        if (t.state != Sending) return;
+
+        // the newest transmission known to have arrived: anything unacknowledged sent before it was lost
+        uint64_t arrived = 0;
+        size_t before = t.acked_count;
+        auto mark = [&](size_t i) {
+            arrived = std::max(arrived, t.sent[i]);
+            if (t.acked[i]) return;
+            t.acked[i] = true;
+            t.acked_count++;
+        };
+        for (size_t i = t.base; i < next; i++) mark(i);
+        for (size_t k = 0; k < 64 && next + 1 + k < t.chunks; k++) {
+            if (bits >> k & 1) mark(next + 1 + k);
+        }
+        while (t.base < t.chunks && t.acked[t.base]) t.base++;
+        t.next = std::max(t.next, t.base);      // a resumed transfer starts where the receiver stopped
+
+        if (t.acked_count > before) {
+            t.retries = 0;
+            t.last_progress = Clock::now();
+        }
+        for (size_t i = t.base; i < t.next; i++) {
+            if (!t.acked[i] && t.sent[i] && t.sent[i] < arrived) sendChunk(t, i);
+        }
+        pump(t);
+    }
+
+    void finished(Outgoing& t, bool ok) {
+        if (t.state == Done || t.state == Failed) return;
+        t.state = ok ? Done : Failed;
+        t.mapping.reset();
+        t.file.reset();
+        t.body.clear();
+        if (ok) notice(t.peer, (t.text ? "[длинное сообщение доставлено, " : "[файл " + t.name + " доставлен, ") + std::to_string(t.size) + " байт]");
+        else notice(t.peer, (t.text ? "[длинное сообщение не принято]" : "[файл " + t.name + " не принят]"));
+    }
+
+    // Receiving
+
+    void save(Incoming& t) {
+        if (t.text || t.state != Receiving) return;
+        std::string have;
+        for (size_t i = t.next; i < t.chunks; i += 4) {
+            int nibble = 0;
+            for (int b = 0; b < 4 && i + b < t.chunks; b++) nibble |= t.have[i + b] << b;
+            have.push_back("0123456789abcdef"[nibble]);
+        }
+        while (!have.empty() && have.back() == '0') have.pop_back();
+
+        t.mapping->flush();     // the bitmap must not get ahead of the bytes
+        db.save_transfer({ t.peer, t.id, t.name, t.size, t.chunk, t.next, have });
+        t.unsaved = 0;
+    }
+
+    void acknowledge(Incoming& t) {
+        uint64_t bits = 0;
+        for (size_t k = 0; k < 64 && t.next + 1 + k < t.chunks; k++) {
+            if (t.have[t.next + 1 + k]) bits |= uint64_t(1) << k;
+        }
+        tell(t.peer, 'A', t.id, std::to_string(t.next) + ' ' + hex(bits));
+        t.unacked = 0;
+    }
+
+    // Reopens a partial file the database knows of, if it is the same transfer
+    bool resume(Incoming& t) {
+        auto saved = db.load_transfer(t.peer, t.id);
+        if (!saved || saved->size != t.size || saved->chunk != t.chunk || !std::filesystem::exists(t.part)) return false;
+
+        t.next = std::min(saved->next, t.chunks);
+        for (size_t i = 0; i < t.next; i++) t.have[i] = true;
+        for (size_t n = 0; n < saved->have.size(); n++) {
+            int nibble;
+            if (!number(std::string_view(&saved->have[n], 1), nibble, 16)) return false;
+            for (int b = 0; b < 4 && t.next + n * 4 + b < t.chunks; b++) t.have[t.next + n * 4 + b] = nibble >> b & 1;
+        }
+        t.received = std::count(t.have.begin(), t.have.end(), true);
+        while (t.next < t.chunks && t.have[t.next]) t.next++;
+        return true;
+    }
+
+    void offered(const std::string& peer, const std::string& id, std::string_view kind, std::string_view size_field, std::string_view chunk_field, std::string_view name) {
+        auto key = peer + ' ' + id;
+        if (auto it = incoming.find(key); it != incoming.end()) {
+            auto& t = *it->second;
+            if (t.state == Failed) incoming.erase(it);      // offered again: start over
+            else {
+                if (t.state == Receiving) acknowledge(t);
+                else tell(peer, 'D', id, "+");
+                return;
+            }
+        }
+
+        auto t = std::make_unique<Incoming>();
+        t->id = id;
+        t->peer = peer;
+        t->text = kind == "T";
+        t->name = safeName(name);
+        if (!number(size_field, t->size) || !number(chunk_field, t->chunk) || t->chunk == 0 || t->chunk > PULSAR_MSG_SIZE
+            || t->size > (t->text ? (size_t)PULSAR_TRANSFER_TEXT_MAX_BYTES : (size_t)PULSAR_TRANSFER_MAX_BYTES)) {
+            tell(peer, 'D', id, "-");
+            return;
+        }
+        t->chunks = chunkCount(t->size, t->chunk);
+        t->have.assign(t->chunks, false);
+
+        if (t->text) t->body.resize(t->size);
+        else {
+            std::filesystem::create_directories(dir);
+            t->part = dir / (peer + '-' + id + ".part");
+            bool resumed = resume(*t);
+            t->file = std::make_unique<MappedFile>(t->part);
+            if (!resumed) t->file->truncate(0);
+            t->mapping = t->file->mapWritable(t->size);
+            if (!resumed) save(*t);
+            notice(peer, "[получение файла " + t->name + ", " + std::to_string(t->size) + " байт"
+                         + (resumed ? ", продолжение с " + std::to_string(t->received * t->chunk) + " байт]" : "]"));
+        }
+
+        acknowledge(*t);
+        incoming[key] = std::move(t);
+    }
+
+    void received(Incoming& t, std::string_view index_field, std::string_view sum_field, std::string_view data) {
+        size_t i;
+        uint32_t sum;
+        if (t.state != Receiving || !number(index_field, i) || !number(sum_field, sum, 16) || i >= t.chunks) return;
+
+        if (t.have[i]) {
+            acknowledge(t);     // our ack was lost, or this is a late copy
+            return;
+        }
+
+        char chunk[PULSAR_MSG_SIZE];
+        auto n = unbase64(data, chunk, sizeof(chunk));
+        if (n != (ptrdiff_t)chunkBytes(t.size, t.chunk, i) || fnv1a(std::string_view(chunk, n)) != sum) return;     // damaged, sent again later
+
+        std::memcpy(t.data() + i * t.chunk, chunk, n);
+        t.have[i] = true;
+        t.received++;
+        t.unsaved++;
+        t.unacked++;
+
+        bool in_order = i == t.next;
+        while (t.next < t.chunks && t.have[t.next]) t.next++;
+
+        // a gap means chunks were lost: tell the sender at once
+        if (!in_order || t.unacked >= PULSAR_TRANSFER_WINDOW / 4 || t.next == t.chunks) acknowledge(t);
+        if (t.unsaved >= PULSAR_TRANSFER_SAVE_CHUNKS) save(t);
+    }
+
+    void ended(Incoming& t, std::string_view sum_field) {
+        if (t.state != Receiving) {
+            tell(t.peer, 'D', t.id, t.state == Done ? "+" : "-");
+            return;
+        }
+        if (t.next < t.chunks) {
+            acknowledge(t);
+            return;
+        }
+
+        uint32_t sum;
+        bool ok = number(sum_field, sum, 16) && totalSum(t.data(), t.size, t.chunk) == sum;
+        t.state = ok ? Done : Failed;
+
+        if (t.text) {
+            if (ok) notices.push_back(Message { 0, Datetime::now().toTime(), t.peer, username, std::move(t.body) });
+            t.body.clear();
+        } else {
+            if (ok) t.mapping->flush();
+            t.mapping.reset();
+            t.file.reset();
+            if (ok) {
+                auto path = freePath(t.name);
+                std::filesystem::rename(t.part, path);
+                notice(t.peer, "[файл " + t.name + " получен: " + path.string() + ", " + std::to_string(t.size) + " байт]");
+            } else {
+                std::filesystem::remove(t.part);
+                notice(t.peer, "[файл " + t.name + " повреждён при передаче и удалён]");
+            }
+            db.remove_transfer(t.peer, t.id);
+        }
+        tell(t.peer, 'D', t.id, ok ? "+" : "-");
+    }
+
+public:
+    /// `send` puts a message to a user on the wire (chunks are `bulk`, the rest is control traffic),
+    /// `notify` shows a notice or a received long text
+    Transfers(Database& db, const std::string& username, Send send, Notify notify)
+     : db(db), username(username), dir(std::filesystem::path(PULSAR_TRANSFER_DIR) / username), send(std::move(send)), notify(std::move(notify)) {}
+
+    /// Partial incoming files are saved, so the next offer of them resumes
+    ~Transfers() {
+        std::lock_guard lk(mtx);
+        for (auto& [key, t] : incoming) {
+            try {
+                save(*t);
+            } catch (const std::exception&) {}
+        }
+    }
+
+    Transfers(const Transfers&) = delete;
+    Transfers& operator=(const Transfers&) = delete;
+
+    static bool isTransfer(const Message& msg) {
+        return !msg.get_msg().empty() && msg.get_msg()[0] == PULSAR_XFER;
+    }
+
+    /// Length of the payload at the start of `payload` if it is a transfer message, otherwise 0.
+    /// It may be longer than `payload` when only the beginning of the message was read so far.
+    static size_t frameLength(std::string_view payload) {
+        if (payload.size() < header + prefix || payload[header] != PULSAR_XFER) return 0;
+        size_t length;
+        if (!number(payload.substr(header + 1, prefix - 1), length) || length <= prefix) return 0;
+        return header + length;
+    }
+
+    /// Sends `path` to `user`, read through a mapping of it. Sending the same unchanged file to the same
+    /// user again resumes a transfer that was cut short. Throws std::runtime_error if the file cannot be read.
+    /// @return transfer id
+    std::string sendFile(const std::string& user, const std::filesystem::path& path) {
+        auto t = std::make_unique<Outgoing>();
+        t->file = std::make_unique<MappedFile>(path, MappedFile::ReadOnly);
+        t->size = t->file->size();
+        t->mapping = t->file->map(t->size, true);
+        t->peer = user;
+        t->name = safeName(path.filename().string());
+        t->text = false;
+
+        auto modified = std::filesystem::last_write_time(path).time_since_epoch().count();
+        t->id = fixed(fnv1a(username + '\n' + user + '\n' + t->name + '\n' + std::to_string(t->size) + '\n' + std::to_string(modified)), 8, 16);
+
+        auto id = t->id;
+        start(std::move(t));
+        return id;
+    }
+
+    /// Sends a message too long for one payload, the receiver shows it whole. Not resumable.
+    /// @return transfer id
+    std::string sendText(const std::string& user, std::string text) {
+        if (text.size() > PULSAR_TRANSFER_TEXT_MAX_BYTES) throw std::length_error("Transfers: text longer than PULSAR_TRANSFER_TEXT_MAX_BYTES");
+
+        auto t = std::make_unique<Outgoing>();
+        t->peer = user;
+        t->name = "text";
+        t->text = true;
+        t->size = text.size();
+        t->id = fixed(fnv1a(username + '\n' + user + '\n' + std::to_string(Clock::now().time_since_epoch().count()) + '\n' + text), 8, 16);
+        t->body = std::move(text);
+
+        auto id = t->id;
+        start(std::move(t));
+        return id;
+    }
+
+    /// Takes an incoming transfer message, called for every message isTransfer() is true for
+    void handle(const Message& msg) {
+        auto& peer = msg.get_src();
+        std::string_view text = msg.get_msg();
+        size_t length;
+        if (text.size() < prefix || !number(text.substr(1, prefix - 1), length) || length <= prefix || length > text.size()) return;
+        if (peer == username || msg.get_dst() != username) return;
+        text = text.substr(prefix, length - prefix);      // a server may have stored several glued together
+
+        {
+            std::lock_guard lk(mtx);
+            auto f = fields(text, 6);
+            if (f.size() < 2 || f[0].size() != 1 || !validId(f[1])) return;
+            std::string id { f[1] };
+            char type = f[0][0];
+
+            try {
+                if (type == 'O') {
+                    if (f.size() == 6) offered(peer, id, f[2], f[3], f[4], f[5]);
+                } else if (type == 'C' || type == 'E') {
+                    auto it = incoming.find(peer + ' ' + id);
+                    if (it != incoming.end()) {
+                        auto c = fields(text, 5);
+                        if (type == 'C' && c.size() == 5) received(*it->second, c[2], c[3], c[4]);
+                        if (type == 'E' && c.size() == 3) ended(*it->second, c[2]);
+                    }
+                } else if (type == 'A' || type == 'D') {
+                    auto it = outgoing.find(id);
+                    if (it != outgoing.end() && it->second->peer == peer) {
+                        auto a = fields(text, 4);
+                        if (type == 'A' && a.size() == 4) acknowledged(*it->second, a[2], a[3]);
+                        if (type == 'D' && a.size() == 3) finished(*it->second, a[2] == "+");
+                    }
+                }
+            } catch (const std::exception&) {
+                // the disk is full or the download directory is not writable: the sender times out
+            }
+        }
+        flushNotices();
+    }
+
+    /// Repeats what got no answer within `timeout`, pauses transfers after PULSAR_TRANSFER_RETRIES such rounds.
+    /// @return whether anything is still being sent, i.e. tick() is needed again
+    bool tick(Clock::duration timeout) {
+        bool active = false;
+        {
+            std::lock_guard lk(mtx);
+            auto now = Clock::now();
+            for (auto& [id, ptr] : outgoing) {
+                auto& t = *ptr;
+                if (t.state != Offered && t.state != Sending && t.state != Finishing) continue;
+                active = true;
+                if (now - t.last_progress < timeout) continue;
+
+                t.last_progress = now;
+                if (++t.retries > PULSAR_TRANSFER_RETRIES) {
+                    t.state = Paused;
+                    notice(t.peer, (t.text ? "[длинное сообщение не доставлено: " : "[передача файла " + t.name + " приостановлена: ") + t.peer + " не отвечает]");
+                    continue;
+                }
+
+                if (t.state == Offered) offer(t);
+                else if (t.state == Finishing) tell(t.peer, 'E', t.id, hex(totalSum(t.data(), t.size, PULSAR_TRANSFER_CHUNK)));
+                else {
+                    for (size_t i = t.base; i < t.next; i++) {
+                        if (!t.acked[i] && !sendChunk(t, i)) break;
+                    }
+                    pump(t);
+                }
+            }
+        }
+        flushNotices();
+        return active;
+    }
+
+    std::vector<Progress> list() {
+        std::vector<Progress> out;
+        std::lock_guard lk(mtx);
+        for (auto& [id, t] : outgoing) {
+            out.push_back({ t->id, t->peer, t->name, false, t->state, t->size, std::min(t->size, t->acked_count * PULSAR_TRANSFER_CHUNK) });
+        }
+        for (auto& [key, t] : incoming) {
+            out.push_back({ t->id, t->peer, t->name, true, t->state, t->size, std::min(t->size, t->received * t->chunk) });
+        }
+        return out;
+    }
+};
@@ -1,11 +1,20 @@
 #pragma once
 
 #include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <iomanip>
+#include <set>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
 #include "console_defines"
 #include "Fastfetch.hpp"
 #include "../defines"
 #include "../API/PulsarAPI.hpp"
+#include "../Other/Metrics.hpp"
 
 class Console {
 private:
@@ -13,9 +22,13 @@ private:
     std::string& dest;
     std::string& name;
 
-    static bool checkLength(const std::string& str, size_t min) {
-        return !(str.size() >= min);
-    }
+    // last !search, a bare !search shows its next page
+    std::string search_text, search_chat;
+    size_t search_offset = 0;
+
+    // scripts being run by !script, one that runs itself again (directly or not) is refused
+    std::set<std::filesystem::path> open_scripts;
+
 public:
     Console(std::shared_ptr<PulsarAPI> api_ptr, std::string& dest_ref, std::string& name_ref)
      : api(api_ptr), dest(dest_ref), name(name_ref) {}
@@ -37,171 +50,413 @@ public:
         #endif
     }
 
+    /// Per-chat counts only, the messages themselves are shown by displayUnreadMessages(chat)
     void displayUnreadMessages() {
-        auto msgs = api->getUnread();
-        if (msgs.size() == 0) {
+        auto total = api->getUnreadCount();
+        if (total == 0) {
             std::cout << "У вас нет непрочитанных сообщений." << std::endl;
             return;
         }
-        std::cout << "У вас есть " << msgs.size() << " непрочитанных сообщений: " << std::endl;
+        std::cout << "У вас есть " << total << " непрочитанных сообщений: " << std::endl;
+        for (auto& [chat, count] : api->getUnreadCounts()) {
+            std::cout << "  " << chat << ": " << count << std::endl;
+        }
+    }
+
+    void displayUnreadMessages(const std::string& chat) {
+        auto msgs = api->getUnread(chat);
+        if (msgs.size() == 0) {
+            std::cout << "В " << chat << " нет непрочитанных сообщений." << std::endl;
+            return;
+        }
         for (auto i : msgs) {
             std::cout << i << std::endl;
         }
     }
 
-    int run(const std::string& command) {
-        auto split_view = split(command);
-        auto com = split_view[0];
-        if (com == "!exit") {
-            api->disconnect();
-        }
-        else if (com == "!dest") {
-            dest = split_view[1];
-        }
-        else if (com == "!join") {
-            if (api->joinChannel(split_view[1])) {
-                std::cout << "Вы успешно присоеденились к каналу '" << split_view[1] << "'." << std::endl;
-            } else std::cout << "Не удалось присоедениться к каналу '" << split_view[1] << "'." << std::endl;
-        } 
-        else if (com == "!leave") {
-            if (api->leaveChannel(split_view[1])) {
-                std::cout << "Вы успешно покинули канал '" << split_view[1] << "'." << std::endl;
-            } else std::cout << "Не удалось покинуть канал '" << split_view[1] << "'." << std::endl;
-        }
-        else if (com == "!create") {
-            if (api->createChannel(split_view[1])) {
-                std::cout << "Создан канал '" << split_view[1] << "'." << std::endl;
-            } else std::cout << "Не удалось создать канал '" << split_view[1] << "'." << std::endl;
-        }
-        else if (com == "!chat") {
-            auto chat = api->getChat(split_view[1]);
-            std::cout << "Чат '" << split_view[1] << "':\n" << chat.to_stream().rdbuf();
-        }
-        else if (com == "!profile") {
-            auto arg = split_view[1];
-
-            if (arg == "edit") {
-                std::string description, email, realName, birthday;
-
-                std::cout << "Введите новое описание: ";
-                std::getline(std::cin, description);
-                std::cout << "Введите новый Email: ";
-                std::getline(std::cin, email);
-                std::cout << "Введите новое имя: ";
-                std::getline(std::cin, realName);
-                std::cout << "Введите новый день рождения (одно число): ";
-                std::getline(std::cin, birthday);
-
-                Profile p { description, email, realName, Datetime(std::stol(birthday)) };
-                
-                if (api->updateProfile(p)) {
-                    std::cout << "Профиль обновлен." << std::endl;
-                } else std::cout << "Не удалось обновить профиль." << std::endl;
-            } else {
-                auto profile = api->getProfile(arg);
-
-                std::cout << "Профиль '" << arg << "':";
-                std::cout << "\n\tОписание: " << profile.description();
-                std::cout << "\n\tEmail: " << profile.email();
-                std::cout << "\n\tИмя: " << profile.realName();
-                std::cout << "\n\tДень рождения: " << profile.birthday().toTime() << std::endl;
+    int run(const std::string& command);
+    int runScript(std::istream& script);
+    void fullHelp();
+    void help(const std::string& command);
+
+private:
+    using Args = std::vector<std::string>;
+
+    int cmdExit(const Args&) {
+        api->disconnect();
+        return PULSAR_EXIT_CODE_DISCONNECT;
+    }
+
+    int cmdDest(const Args& args) {
+        dest = args[0];
+        return PULSAR_EXIT_CODE_SUCCESS;
+    }
+
+    int cmdJoin(const Args& args) {
+        if (api->joinChannel(args[0])) {
+            std::cout << "Вы успешно присоеденились к каналу '" << args[0] << "'." << std::endl;
+            return PULSAR_EXIT_CODE_SUCCESS;
+        }
+        std::cout << "Не удалось присоедениться к каналу '" << args[0] << "'." << std::endl;
+        return PULSAR_EXIT_CODE_FAILURE;
+    }
+
+    int cmdLeave(const Args& args) {
+        if (api->leaveChannel(args[0])) {
+            std::cout << "Вы успешно покинули канал '" << args[0] << "'." << std::endl;
+            return PULSAR_EXIT_CODE_SUCCESS;
+        }
+        std::cout << "Не удалось покинуть канал '" << args[0] << "'." << std::endl;
+        return PULSAR_EXIT_CODE_FAILURE;
+    }
+
+    int cmdCreate(const Args& args) {
+        if (api->createChannel(args[0])) {
+            std::cout << "Создан канал '" << args[0] << "'." << std::endl;
+            return PULSAR_EXIT_CODE_SUCCESS;
+        }
+        std::cout << "Не удалось создать канал '" << args[0] << "'." << std::endl;
+        return PULSAR_EXIT_CODE_FAILURE;
+    }
+
+    int cmdChat(const Args& args) {
+        auto chat = api->getChat(args[0]);
+        std::cout << "Чат '" << args[0] << "':\n" << chat.to_stream().rdbuf();
+        return PULSAR_EXIT_CODE_SUCCESS;
+    }
+
+    int cmdProfile(const Args& args) {
+        auto& arg = args[0];
+
+        if (arg == "edit") {
+            std::string description, email, realName, birthday;
+
+            std::cout << "Введите новое описание: ";
+            std::getline(std::cin, description);
+            std::cout << "Введите новый Email: ";
+            std::getline(std::cin, email);
+            std::cout << "Введите новое имя: ";
+            std::getline(std::cin, realName);
+            std::cout << "Введите новый день рождения (одно число): ";
+            std::getline(std::cin, birthday);
+
+            Profile p { description, email, realName, Datetime(std::stol(birthday)) };
+
+            if (api->updateProfile(p)) {
+                std::cout << "Профиль обновлен." << std::endl;
+                return PULSAR_EXIT_CODE_SUCCESS;
             }
+            std::cout << "Не удалось обновить профиль." << std::endl;
+            return PULSAR_EXIT_CODE_FAILURE;
         }
-        else if (com == "!contact") {
-            auto act = split_view[1];
-            auto username = split_view[2];
-
-            if (act == "add") {
-                if (api->createContact(username, split_view[3])) {
-                    std::cout << "Создан контакт '" << split_view[3] << "'." << std::endl;
-                } else std::cout << "Не удалось создать контакт '" << split_view[3] << "'." << std::endl;
-            } else if (act == "rem") {
-                if (api->removeContact(username)) {
-                    std::cout << "Удален контакт для '" << username << "'." << std::endl;
-                } else std::cout << "Не удалось удалить контакт для '" << username << "'." << std::endl;
+
+        auto profile = api->getProfile(arg);
+
+        std::cout << "Профиль '" << arg << "':";
+        std::cout << "\n\tОписание: " << profile.description();
+        std::cout << "\n\tEmail: " << profile.email();
+        std::cout << "\n\tИмя: " << profile.realName();
+        std::cout << "\n\tДень рождения: " << profile.birthday().toTime() << std::endl;
+        return PULSAR_EXIT_CODE_SUCCESS;
+    }
+
+    int cmdContact(const Args& args) {
+        auto& act = args[0];
+        auto& username = args[1];
+
+        if (act == "add") {
+            if (args.size() < 3) return PULSAR_EXIT_CODE_INVALID_ARGS;
+
+            if (api->createContact(username, args[2])) {
+                std::cout << "Создан контакт '" << args[2] << "'." << std::endl;
+                return PULSAR_EXIT_CODE_SUCCESS;
             }
+            std::cout << "Не удалось создать контакт '" << args[2] << "'." << std::endl;
+            return PULSAR_EXIT_CODE_FAILURE;
         }
-        else if (com == "!unread") {
-            displayUnreadMessages();
+        if (act == "rem") {
+            if (api->removeContact(username)) {
+                std::cout << "Удален контакт для '" << username << "'." << std::endl;
+                return PULSAR_EXIT_CODE_SUCCESS;
+            }
+            std::cout << "Не удалось удалить контакт для '" << username << "'." << std::endl;
+            return PULSAR_EXIT_CODE_FAILURE;
         }
-        else if (com == "!read") {
-            if (split_view.size() == 2 && split_view[1] == "all") api->readAll();
-
-            auto chat = split_view[1];
-            auto arg = split_view[2];
+        return PULSAR_EXIT_CODE_INVALID_ARGS;
+    }
 
-            if (arg == "all") {
-                api->readAll(chat);
-            } else {
-                api->read(chat, std::stoll(arg));
+    int cmdSearch(const Args& args) {
+        if (!args.empty()) {
+            auto words = args;
+            search_chat.clear();
+            if (words.size() > 1 && (words.back()[0] == ':' || words.back()[0] == '@')) {
+                search_chat = words.back();
+                words.pop_back();
             }
+            search_text = join(words);
+            search_offset = 0;
         }
-        else if (command == "!fastfetch") {
-            const std::vector<std::string> info = {
-                "Pulsar Client " + std::string(PULSAR_VERSION),
-                "Пользователь: " + name,
-                "Сервер: " + api->getSocket()->getRemoteAddress()->toString() + ":" + std::to_string(api->getSocket()->getRemotePort())
-            };
-            fastfetch(info);
+        if (search_text.empty()) return PULSAR_EXIT_CODE_INVALID_ARGS;
+
+        auto found = api->search(search_text, search_chat, PULSAR_SEARCH_PAGE + 1, search_offset);
+        bool more = found.size() > PULSAR_SEARCH_PAGE;
+        if (more) found.pop_back();
+
+        if (found.empty()) {
+            std::cout << (search_offset ? "Больше ничего не найдено." : "Ничего не найдено.") << std::endl;
+            return PULSAR_EXIT_CODE_SUCCESS;
         }
-        else if (command == "!help") {
-            fullHelp();
+        for (auto& msg : found) std::cout << msg << std::endl;
+
+        search_offset += found.size();
+        if (more) std::cout << "Следующие результаты: !search" << std::endl;
+        return PULSAR_EXIT_CODE_SUCCESS;
+    }
+
+    int cmdSend(const Args& args) {
+        if (args[0][0] != '@') {
+            std::cout << "Файлы можно отправлять только пользователям." << std::endl;
+            return PULSAR_EXIT_CODE_FAILURE;
         }
-        else if (command.substr(0, 5) == "!help") {
-            if (checkLength(command, 7)) help("!help");
-            else help(command.substr(6));
+        if (!std::filesystem::is_regular_file(args[1])) {
+            std::cout << "Не удалось открыть файл '" << args[1] << "'." << std::endl;
+            return PULSAR_EXIT_CODE_FAILURE;
         }
-        else {
-            if (command[0] == '!')
-            return PULSAR_EXIT_CODE_INVALID_COMMAND;
+        auto id = api->sendFile(args[0], args[1]);
+        std::cout << "Файл '" << args[1] << "' отправляется " << args[0] << " (передача " << id << "), ход передачи: !transfers" << std::endl;
+        return PULSAR_EXIT_CODE_SUCCESS;
+    }
+
+    int cmdTransfers(const Args&) {
+        auto list = api->getTransfers();
+        if (list.empty()) {
+            std::cout << "Передач файлов не было." << std::endl;
+            return PULSAR_EXIT_CODE_SUCCESS;
+        }
+        static const char* states[] = { "ожидает ответа", "отправляется", "проверяется", "принимается", "завершена", "не удалась", "приостановлена" };
+        for (auto& t : list) {
+            std::cout << "  " << t.id << (t.incoming ? " от " : " для ") << t.peer << ": " << t.name << ", "
+                      << t.done << " из " << t.size << " байт, " << states[t.state] << std::endl;
         }
         return PULSAR_EXIT_CODE_SUCCESS;
     }
 
-    void fullHelp() {
-        std::cout << "\tДоступные команды:\n"
-                        "!exit                                         - Отключиться и выйти\n"
-                        "!dest <channel/user>                          - Сменить назначение сообщений\n"
-                        "!join <channel>                               - Присоединиться к каналу\n"
-                        "!leave <channel>                              - Покинуть канал\n"
-                        "!create <channel>                             - Создать канал\n"
-                        "!chat <channel/user>                          - Посмотреть историю чата\n"
-                        "!profile <username>|edit                      - Посмотреть или изменить профиль\n"
-                        "!contact <add/rem> <username> <contact>       - Добавить или удалить контакт\n"
-                        "!unread                                       - Посмотреть непрочитанные сообщения\n"
-                        "!read <chat> <id>|all                         - Прочитать сообщение по ID из чата\n"
-                        "!fastfetch                                    - Вывести информацию о клиенте\n"
-                        "!help                                         - Вывести это окно\n"
-        << std::flush;
-    }
-
-    void help(const std::string& command) {
-        if (command == "!help") {
-            fullHelp();
-        } else if (command == "!exit") {
-            std::cout << "!exit - Отключиться от сервера и выйти из клиента." << std::endl;
-        } else if (command == "!dest") {
-            std::cout << "!dest <channel/user> - Сменить назначение для отправляемых сообщений." << std::endl;
-        } else if (command == "!join") {
-            std::cout << "!join <channel> - Присоединиться к указанному каналу." << std::endl;
-        } else if (command == "!leave") {
-            std::cout << "!leave <channel> - Покинуть указанный канал." << std::endl;
-        } else if (command == "!create") {
-            std::cout << "!create <channel> - Создать новый канал с указанным именем." << std::endl;
-        } else if (command == "!chat") {
-            std::cout << "!chat <channel/user> - Просмотреть историю чата с указанным каналом или пользователем." << std::endl;
-        } else if (command == "!profile") {
-            std::cout << "!profile <username>|edit - Просмотреть профиль пользователя или изменить свой собственный." << std::endl;
-        } else if (command == "!contact") {
-            std::cout << "!contact <add/rem> <username> <contact> - Добавить или удалить контакт для указанного пользователя." << std::endl;
-        } else if (command == "!unread") {
-            std::cout << "!unread - Просмотреть все непрочитанные сообщения." << std::endl;
-        } else if (command == "!read") {
-            std::cout << "!read <chat> <id>|all - Пометить сообщение по ID в указанном чате как прочитанное, или все сообщения." << std::endl;
-        } else if (command == "!fastfetch") {
-            std::cout << "!fastfetch - Вывести информацию о клиенте." << std::endl;
-        } else {
-            std::cout << "Нет справки по команде: " << command << std::endl;
-        }
-    }
-};
\ No newline at end of file
+    int cmdUnread(const Args& args) {
+        if (args.empty()) displayUnreadMessages();
+        else displayUnreadMessages(args[0]);
+        return PULSAR_EXIT_CODE_SUCCESS;
+    }
+
+    int cmdRead(const Args& args) {
+        if (args.size() == 1) {
+            if (args[0] != "all") return PULSAR_EXIT_CODE_INVALID_ARGS;
+            api->readAll();
+            return PULSAR_EXIT_CODE_SUCCESS;
+        }
+
+        if (args[1] == "all") api->readAll(args[0]);
+        else api->read(args[0], std::stoll(args[1]));
+        return PULSAR_EXIT_CODE_SUCCESS;
+    }
+
+    int cmdFastfetch(const Args&) {
+        auto address = api->getSocket()->getRemoteAddress();
+        auto rtt = api->getRtt();
+
+        auto ms = [](double value) {
+            std::ostringstream oss;
+            oss << std::fixed << std::setprecision(1) << value << " мс";
+            return oss.str();
+        };
+
+        const std::vector<std::string> info = {
+            "Pulsar Client " + std::string(PULSAR_VERSION),
+            "Пользователь: " + name,
+            "Сервер: " + (address ? address->toString() + ":" + std::to_string(api->getSocket()->getRemotePort()) : std::string("нет соединения")),
+            "RTT: " + (rtt.measured ? ms(rtt.srtt_ms) + " ± " + ms(rtt.rttvar_ms) : std::string("нет данных")),
+            "Таймаут запросов: " + ms(rtt.rto_ms)
+        };
+        fastfetch(info);
+        return PULSAR_EXIT_CODE_SUCCESS;
+    }
+
+    int cmdHelp(const Args& args) {
+        if (args.empty()) fullHelp();
+        else help(args[0]);
+        return PULSAR_EXIT_CODE_SUCCESS;
+    }
+
+    int cmdStats(const Args&) {
+        std::cout << "Метрики клиента:" << std::endl;
+        Metrics::Registry::global().summary(std::cout);
+        return PULSAR_EXIT_CODE_SUCCESS;
+    }
+
+    int cmdScript(const Args& args) {
+        std::ifstream file(args[0]);
+        if (!file) {
+            std::cout << "Не удалось открыть файл '" << args[0] << "'." << std::endl;
+            return PULSAR_EXIT_CODE_FAILURE;
+        }
+
+        std::error_code ec;
+        auto path = std::filesystem::weakly_canonical(args[0], ec);
+        if (ec) path = std::filesystem::absolute(args[0]);
+        if (!open_scripts.insert(path).second) {
+            std::cout << "Скрипт '" << args[0] << "' уже выполняется, повторный запуск пропущен." << std::endl;
+            return PULSAR_EXIT_CODE_FAILURE;
+        }
+
+        int res = runScript(file);
+        open_scripts.erase(path);
+        return res;
+    }
+
+public:
+    struct Command {
+        std::string_view name;
+        size_t min_args, max_args;
+        int (Console::*handler)(const Args&);
+        std::string_view usage;
+        std::string_view summary;
+        std::string_view description;
+    };
+
+    static const Command commands[];
+
+    static const Command* find(std::string_view name);
+};
+
+// Must be sorted by name: lookup is a binary search
+inline constexpr Console::Command Console::commands[] = {
+    { "!chat",      1, 1, &Console::cmdChat,      "!chat <channel/user>",
+        "Посмотреть историю чата",
+        "Просмотреть историю чата с указанным каналом или пользователем." },
+    { "!contact",   2, 3, &Console::cmdContact,   "!contact <add/rem> <username> <contact>",
+        "Добавить или удалить контакт",
+        "Добавить или удалить контакт для указанного пользователя." },
+    { "!create",    1, 1, &Console::cmdCreate,    "!create <channel>",
+        "Создать канал",
+        "Создать новый канал с указанным именем." },
+    { "!dest",      1, 1, &Console::cmdDest,      "!dest <channel/user>",
+        "Сменить назначение сообщений",
+        "Сменить назначение для отправляемых сообщений." },
+    { "!exit",      0, 0, &Console::cmdExit,      "!exit",
+        "Отключиться и выйти",
+        "Отключиться от сервера и выйти из клиента." },
+    { "!fastfetch", 0, 0, &Console::cmdFastfetch, "!fastfetch",
+        "Вывести информацию о клиенте",
+        "Вывести информацию о клиенте." },
+    { "!help",      0, 1, &Console::cmdHelp,      "!help [command]",
+        "Вывести это окно",
+        "Вывести список команд или справку по команде." },
+    { "!join",      1, 1, &Console::cmdJoin,      "!join <channel>",
+        "Присоединиться к каналу",
+        "Присоединиться к указанному каналу." },
+    { "!leave",     1, 1, &Console::cmdLeave,     "!leave <channel>",
+        "Покинуть канал",
+        "Покинуть указанный канал." },
+    { "!profile",   1, 1, &Console::cmdProfile,   "!profile <username>|edit",
+        "Посмотреть или изменить профиль",
+        "Просмотреть профиль пользователя или изменить свой собственный." },
+    { "!read",      1, 2, &Console::cmdRead,      "!read <chat> <id>|all",
+        "Прочитать сообщение по ID из чата",
+        "Пометить сообщение по ID в указанном чате как прочитанное, или все сообщения." },
+    { "!script",    1, 1, &Console::cmdScript,    "!script <file>",
+        "Выполнить команды из файла",
+        "Выполнить команды и отправить сообщения из файла построчно (строки с '#' пропускаются)." },
+    { "!search",    0, 16, &Console::cmdSearch,   "!search [query] [chat]",
+        "Искать в сохранённых сообщениях",
+        "Найти сообщения со всеми словами запроса ('слово*' - по началу слова) в локальной истории, лучшие совпадения первыми. Без аргументов - следующая страница." },
+    { "!send",      2, 2, &Console::cmdSend,      "!send <user> <file>",
+        "Отправить файл",
+        "Отправить файл пользователю по частям. Прерванная передача того же файла продолжается с места обрыва." },
+    { "!stats",     0, 0, &Console::cmdStats,     "!stats",
+        "Вывести метрики клиента",
+        "Вывести счётчики сообщений и трафика, глубину очередей и задержки запросов, SQLite и шифрования." },
+    { "!transfers", 0, 0, &Console::cmdTransfers, "!transfers",
+        "Показать передачи файлов",
+        "Показать отправляемые и принимаемые файлы и длинные сообщения, сколько байт передано и состояние передачи." },
+    { "!unread",    0, 1, &Console::cmdUnread,    "!unread [chat]",
+        "Посмотреть непрочитанные сообщения",
+        "Без аргумента показать, сколько непрочитанных сообщений в каждом чате, с названием чата - сами сообщения." },
+};
+
+static_assert(std::ranges::is_sorted(Console::commands, {}, &Console::Command::name),
+              "Console::commands must be sorted by name");
+
+inline const Console::Command* Console::find(std::string_view name) {
+    auto it = std::ranges::lower_bound(commands, name, {}, &Command::name);
+    if (it == std::end(commands) || it->name != name) return nullptr;
+    return it;
+}
+
+inline int Console::run(const std::string& command) {
+    std::string buffer = command;
+    Args args;
+    for (auto token : Tokenizer(buffer)) args.emplace_back(token);
+    if (args.empty() || args[0][0] != '!') return PULSAR_EXIT_CODE_INVALID_COMMAND;
+
+    auto cmd = find(args[0]);
+    if (!cmd) {
+        std::cout << "Неизвестная команда '" << args[0] << "'. Список команд: !help" << std::endl;
+        return PULSAR_EXIT_CODE_INVALID_COMMAND;
+    }
+
+    args.erase(args.begin());
+    if (args.size() < cmd->min_args || args.size() > cmd->max_args) {
+        std::cout << "Неверные аргументы. Использование: " << cmd->usage << std::endl;
+        return PULSAR_EXIT_CODE_INVALID_ARGS;
+    }
+
+    try {
+        int code = (this->*cmd->handler)(args);
+        if (code == PULSAR_EXIT_CODE_INVALID_ARGS) {
+            std::cout << "Неверные аргументы. Использование: " << cmd->usage << std::endl;
+        }
+        return code;
+    } catch (const std::exception& e) {
+        std::cout << "Ошибка выполнения " << cmd->name << ": " << e.what() << std::endl;
+        return PULSAR_EXIT_CODE_FAILURE;
+    }
+}
+
+inline int Console::runScript(std::istream& script) {
+    size_t total = 0, failed = 0;
+    sf::Clock clk;
+
+    std::string line;
+    while (api->isConnected() && std::getline(script, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        total++;
+        if (line[0] == '!') {
+            if (run(line) != PULSAR_EXIT_CODE_SUCCESS) failed++;
+        } else api->send(line, dest);
+    }
+
+    std::cout << "Выполнено строк: " << total << " (ошибок: " << failed << ") за " << clk.getElapsedTime().asMilliseconds() << " мс." << std::endl;
+    return failed ? PULSAR_EXIT_CODE_FAILURE : PULSAR_EXIT_CODE_SUCCESS;
+}
+
+inline void Console::fullHelp() {
+    std::cout << "\tДоступные команды:\n";
+    for (auto& cmd : commands) {
+        std::cout << std::setw(46) << std::left << cmd.usage << "- " << cmd.summary << '\n';
+    }
+    std::cout << std::flush;
+}
+
+inline void Console::help(const std::string& command) {
+    auto cmd = find(command[0] == '!' ? command : "!" + command);
+    if (!cmd) {
+        std::cout << "Нет справки по команде: " << command << std::endl;
+        return;
+    }
+    if (cmd->name == "!help") {
+        fullHelp();
+        return;
+    }
+    std::cout << cmd->usage << " - " << cmd->description << std::endl;
+}
@@ -0,0 +1,340 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdio>
+#include <iostream>
+
+#ifdef _WIN32
+#   include <windows.h>
+#   include <conio.h>
+#else
+#   include <termios.h>
+#   include <unistd.h>
+#   include <poll.h>
+#   include <fcntl.h>
+#endif
+
+// Event-driven line editor for the console client.
+// One thread owns the terminal and calls poll(); any thread may print() lines,
+// they are queued and drawn above the prompt on the next frame.
+// Every frame is emitted with a single write.
+class Terminal {
+public:
+    enum Event {
+        None,
+        Line,
+        Eof
+    };
+
+    // Restores the cooked terminal for the lifetime of the scope
+    // (for commands that read std::cin or print a lot to std::cout)
+    class Suspend {
+    private:
+        Terminal& term;
+    public:
+        Suspend(Terminal& term) : term(term) { term.suspend(); }
+        ~Suspend() { term.resume(); }
+    };
+
+private:
+    std::string prompt;
+    std::string input;
+    std::string shown;          // prompt + input as currently drawn on screen
+    bool drawn = false;
+    bool dirty = true;
+    bool suspended = false;
+
+    std::mutex pending_mtx;
+    std::vector<std::string> pending;
+    std::vector<std::string> lines;  // swapped with pending, keeps its capacity
+    std::string frame;
+
+    int esc_state = 0;          // 0 - none, 1 - after ESC, 2 - inside CSI
+
+    bool tty_in = false;
+    bool tty_out = false;
+
+#ifdef _WIN32
+    HANDLE in_handle = nullptr;
+    HANDLE out_handle = nullptr;
+    HANDLE wake_event = nullptr;
+    DWORD saved_in_mode = 0;
+    DWORD saved_out_mode = 0;
+#else
+    termios saved {};
+    int wake_fd[2] = { -1, -1 };
+    std::string unread;         // reversed bytes left over after a completed line
+#endif
+
+    void enterRaw() {
+#ifdef _WIN32
+        if (tty_in) SetConsoleMode(in_handle, saved_in_mode & ~(ENABLE_LINE_INPUT | ENABLE_ECHO_INPUT));
+        if (tty_out) SetConsoleMode(out_handle, saved_out_mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+#else
+        if (!tty_in) return;
+        termios raw = saved;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+#endif
+    }
+
+    void leaveRaw() {
+#ifdef _WIN32
+        if (tty_in) SetConsoleMode(in_handle, saved_in_mode);
+#else
+        if (tty_in) tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+#endif
+    }
+
+    void writeOut(const std::string& data) {
+        if (data.empty()) return;
+        std::cout.flush();
+#ifdef _WIN32
+        DWORD written;
+        WriteFile(out_handle, data.data(), (DWORD)data.size(), &written, nullptr);
+#else
+        size_t off = 0;
+        while (off < data.size()) {
+            auto n = ::write(STDOUT_FILENO, data.data() + off, data.size() - off);
+            if (n <= 0) break;
+            off += n;
+        }
+#endif
+    }
+
+    void drainWake() {
+#ifdef _WIN32
+        ResetEvent(wake_event);
+#else
+        char buf[64];
+        while (::read(wake_fd[0], buf, sizeof(buf)) > 0) {}
+#endif
+    }
+
+    static void popCodepoint(std::string& s) {
+        while (!s.empty() && (s.back() & 0xC0) == 0x80) s.pop_back();
+        if (!s.empty()) s.pop_back();
+    }
+
+    // Returns Line or Eof when the key completes the input
+    Event feed(char c, std::string& line) {
+        if (esc_state == 1) {
+            esc_state = (c == '[' || c == 'O') ? 2 : 0;
+            return None;
+        }
+        if (esc_state == 2) {
+            if (c >= 0x40 && c <= 0x7E) esc_state = 0;
+            return None;
+        }
+
+        switch (c) {
+            case '\r':
+            case '\n': {
+                line.swap(input);
+                input.clear();
+                return Line;
+            }
+            case '\x7f':
+            case '\b': popCodepoint(input); break;
+            case '\x15': input.clear(); break;                  // Ctrl+U
+            case '\x17': {                                      // Ctrl+W
+                while (!input.empty() && input.back() == ' ') input.pop_back();
+                while (!input.empty() && input.back() != ' ') input.pop_back();
+            } break;
+            case '\x04': if (input.empty()) return Eof; break;  // Ctrl+D
+            case '\x1b': esc_state = 1; break;
+            default: {
+                if ((unsigned char)c >= 0x20) input.push_back(c);
+            } break;
+        }
+        return None;
+    }
+
+    Event readInput(std::string& line) {
+#ifdef _WIN32
+        while (_kbhit()) {
+            wchar_t wc = _getwch();
+            if (wc == 0 || wc == 0xE0) { _getwch(); continue; }  // arrows, function keys
+            char buf[8];
+            int n = WideCharToMultiByte(CP_UTF8, 0, &wc, 1, buf, sizeof(buf), nullptr, nullptr);
+            for (int i = 0; i < n; i++) {
+                auto ev = feed(buf[i], line);
+                if (ev != None) return ev;
+            }
+        }
+        return None;
+#else
+        char buf[256];
+        auto n = ::read(STDIN_FILENO, buf, sizeof(buf));
+        if (n == 0) return Eof;
+        for (ssize_t i = 0; i < n; i++) {
+            auto ev = feed(buf[i], line);
+            if (ev != None) {
+                // keep the rest of the chunk for the next poll (pasted text)
+                for (ssize_t j = n - 1; j > i; j--) unread.push_back(buf[j]);
+                return ev;
+            }
+        }
+        return None;
+#endif
+    }
+
+    // `committed` is the line just completed with ENTER, it stays on screen
+    void render(const std::string* committed) {
+        frame.clear();
+
+        {
+            std::lock_guard lk(pending_mtx);
+            lines.swap(pending);
+        }
+
+        std::string next = prompt + (committed ? *committed : input);
+
+        if (!lines.empty() || !drawn || dirty) {
+            if (drawn && tty_out) frame += "\r\033[2K";
+            for (auto& l : lines) {
+                frame += l;
+                frame += '\n';
+            }
+            frame += next;
+        } else if (next.compare(0, shown.size(), shown) == 0) {
+            frame.append(next, shown.size());               // typed characters only
+        } else if (shown.compare(0, next.size(), next) == 0) {
+            for (size_t i = next.size(); i < shown.size(); i++) {
+                if ((shown[i] & 0xC0) != 0x80) frame += "\b \b";
+            }
+        } else {
+            if (tty_out) frame += "\r\033[2K";
+            frame += next;
+        }
+
+        if (committed) {
+            frame += '\n';
+            drawn = false;
+            shown.clear();
+        } else {
+            drawn = true;
+            shown = std::move(next);
+        }
+        dirty = false;
+        lines.clear();
+
+        writeOut(frame);
+    }
+
+public:
+    Terminal() {
+#ifdef _WIN32
+        in_handle = GetStdHandle(STD_INPUT_HANDLE);
+        out_handle = GetStdHandle(STD_OUTPUT_HANDLE);
+        tty_in = GetConsoleMode(in_handle, &saved_in_mode);
+        tty_out = GetConsoleMode(out_handle, &saved_out_mode);
+        wake_event = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+#else
+        tty_in = isatty(STDIN_FILENO);
+        tty_out = isatty(STDOUT_FILENO);
+        if (tty_in) tcgetattr(STDIN_FILENO, &saved);
+        if (pipe(wake_fd) == 0) {
+            fcntl(wake_fd[0], F_SETFL, O_NONBLOCK);
+            fcntl(wake_fd[1], F_SETFL, O_NONBLOCK);
+        }
+#endif
+        enterRaw();
+    }
+
+    ~Terminal() {
+        if (drawn) writeOut("\n");
+        leaveRaw();
+#ifdef _WIN32
+        if (tty_out) SetConsoleMode(out_handle, saved_out_mode);
+        CloseHandle(wake_event);
+#else
+        close(wake_fd[0]);
+        close(wake_fd[1]);
+#endif
+    }
+
+    Terminal(const Terminal&) = delete;
+    Terminal& operator=(const Terminal&) = delete;
+
+    void setPrompt(const std::string& p) {
+        if (p == prompt) return;
+        prompt = p;
+        dirty = true;
+    }
+
+    // Thread-safe. The line is drawn above the prompt on the next frame.
+    void print(std::string line) {
+        {
+            std::lock_guard lk(pending_mtx);
+            pending.push_back(std::move(line));
+        }
+#ifdef _WIN32
+        SetEvent(wake_event);
+#else
+        char c = 0;
+        (void)!::write(wake_fd[1], &c, 1);
+#endif
+    }
+
+    // Waits up to timeout_ms for a key or a printed line and redraws the screen.
+    // Returns Line with the entered text in `line` when ENTER is pressed.
+    Event poll(std::string& line, int timeout_ms) {
+        Event ev = None;
+
+#ifdef _WIN32
+        HANDLE handles[] = { wake_event, in_handle };
+        auto res = WaitForMultipleObjects(2, handles, FALSE, timeout_ms);
+        if (res == WAIT_OBJECT_0) drainWake();
+        else if (res == WAIT_OBJECT_0 + 1) {
+            if (tty_in) ev = readInput(line);
+            else {
+                if (!std::getline(std::cin, line)) ev = Eof;
+                else ev = Line;
+            }
+        }
+#else
+        while (!unread.empty() && ev == None) {
+            char c = unread.back();
+            unread.pop_back();
+            ev = feed(c, line);
+        }
+
+        if (ev == None) {
+            pollfd fds[2] = {
+                { STDIN_FILENO, POLLIN, 0 },
+                { wake_fd[0],   POLLIN, 0 }
+            };
+            if (::poll(fds, 2, timeout_ms) > 0) {
+                if (fds[1].revents & POLLIN) drainWake();
+                if (fds[0].revents & (POLLIN | POLLHUP)) ev = readInput(line);
+            }
+        }
+#endif
+
+        render(ev == Line ? &line : nullptr);
+        return ev;
+    }
+
+    void suspend() {
+        if (suspended) return;
+        suspended = true;
+        if (drawn) {
+            writeOut(tty_out ? "\r\033[2K" : "\n");
+            drawn = false;
+            shown.clear();
+        }
+        leaveRaw();
+    }
+
+    void resume() {
+        if (!suspended) return;
+        suspended = false;
+        enterRaw();
+        dirty = true;
+    }
+};
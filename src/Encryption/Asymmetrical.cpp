@@ -0,0 +1,30 @@
+#include "Asymmetrical.hpp"
+
+namespace PulsarCrypto {
+    namespace Asymmetrical {
+        namespace RSA {
+            big enc(big b, const key& key) {
+                return pow_mod(b, key.s, key.n);
+            }
+
+            big dec(big b, const key& key) {
+                return pow_mod(b, key.s, key.n);
+            }
+        };
+
+        bytes encrypt(const bytes& msg, RSA::key pub) {
+            bytes res;
+            for (ubyte c : msg) res.push_back(enc((big)c, pub));
+            return res;
+        }
+
+        bytes decrypt(const bytes& msg, RSA::key priv) {
+            bytes res;
+            for (big c : msg) {
+                big d = dec(c, priv);
+                res.push_back(static_cast<ubyte>(d & 0xFF));
+            }
+            return res;
+        }
+    };
+};
@@ -20,13 +20,9 @@ namespace PulsarCrypto {
                 key pub, priv;
             };
 
-            big enc(big b, const key& key) {
-                return pow_mod(b, key.s, key.n);
-            }
+            big enc(big b, const key& key);
 
-            big dec(big b, const key& key) {
-                return pow_mod(b, key.s, key.n);
-            }
+            big dec(big b, const key& key);
 
             class Generator {
             private:
@@ -68,19 +64,8 @@ namespace PulsarCrypto {
             };
         };
 
-        bytes encrypt(const bytes& msg, RSA::key pub) {
-            bytes res;
-            for (ubyte c : msg) res.push_back(enc((big)c, pub));
-            return res;
-        }
+        bytes encrypt(const bytes& msg, RSA::key pub);
 
-        bytes decrypt(const bytes& msg, RSA::key priv) {
-            bytes res;
-            for (big c : msg) {
-                big d = dec(c, priv);
-                res.push_back(static_cast<ubyte>(d & 0xFF));
-            }
-            return res;
-        }
+        bytes decrypt(const bytes& msg, RSA::key priv);
     };
 };
\ No newline at end of file
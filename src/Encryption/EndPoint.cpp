@@ -0,0 +1,58 @@
+#include "EndPoint.hpp"
+#include "../Other/Metrics.hpp"
+#include "../Other/Trace.hpp"
+
+static Metrics::Histogram& crypto_latency(const std::string& op) {
+    return Metrics::Registry::global().histogram("pulsar_crypto_seconds", "Time spent in password hashing and encryption", Metrics::label("op", op));
+}
+
+namespace PulsarCrypto {
+    namespace end {
+        Asymmetrical::RSA::key_pair generate_rsa() {
+            static auto& latency = crypto_latency("generate_rsa");
+            Metrics::Timer timer(latency);
+            PULSAR_TRACE_SCOPE("generate_rsa");
+            Asymmetrical::RSA::Generator gen;
+            return Asymmetrical::RSA::key_pair { gen.getPublic(), gen.getPrivate() };
+        }
+
+        Symmetrical::PESA generate_sym() {
+            static auto& latency = crypto_latency("generate_sym");
+            Metrics::Timer timer(latency);
+            PULSAR_TRACE_SCOPE("generate_sym");
+            return Symmetrical::PESA { Symmetrical::random_symkey() } ;
+        }
+
+        std::string enc_rsa(std::string raw, Asymmetrical::RSA::key& pub) {
+            static auto& latency = crypto_latency("enc_rsa");
+            Metrics::Timer timer(latency);
+            PULSAR_TRACE_SCOPE("enc_rsa");
+            auto enc_raw = Asymmetrical::encrypt(to_bytes(std::move(raw)), pub);
+            return from_bytes(enc_raw);
+        }
+
+        std::string dec_rsa(std::string raw, Asymmetrical::RSA::key& priv) {
+            static auto& latency = crypto_latency("dec_rsa");
+            Metrics::Timer timer(latency);
+            PULSAR_TRACE_SCOPE("dec_rsa");
+            auto dec_raw = Asymmetrical::decrypt(to_bytes(std::move(raw)), priv);
+            return from_bytes(dec_raw);
+        }
+
+        std::string enc_sym(std::string raw, Symmetrical::PESA& key) {
+            static auto& latency = crypto_latency("enc_sym");
+            Metrics::Timer timer(latency);
+            PULSAR_TRACE_SCOPE("enc_sym");
+            auto enc_raw = Symmetrical::encrypt(to_bytes(std::move(raw)), key);
+            return from_bytes(enc_raw);
+        }
+
+        std::string dec_sym(std::string raw, Symmetrical::PESA& key) {
+            static auto& latency = crypto_latency("dec_sym");
+            Metrics::Timer timer(latency);
+            PULSAR_TRACE_SCOPE("dec_sym");
+            auto dec_raw = Symmetrical::decrypt(to_bytes(std::move(raw)), key);
+            return from_bytes(dec_raw);
+        }
+    };
+};
@@ -3,7 +3,7 @@
 #include "static"
 
 namespace PulsarCrypto {
-    static inline bytes random_bytes(size_t n) {
+    inline bytes random_bytes(size_t n) {
         static std::random_device rd;
         static std::mt19937_64 gen(rd());
         static std::uniform_int_distribution<big> dist64(0, UINT64_MAX);
@@ -24,7 +24,7 @@ namespace PulsarCrypto {
         return out;
     }
 
-    static inline big random_big(big min, big max) {
+    inline big random_big(big min, big max) {
         static std::random_device rd;
         static std::mt19937_64 gen(rd());
         std::uniform_int_distribution<big> dist(min, max);
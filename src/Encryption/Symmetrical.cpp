@@ -0,0 +1,22 @@
+#include "Symmetrical.hpp"
+
+namespace PulsarCrypto {
+    namespace Symmetrical {
+        big random_symkey() {
+            auto index = random_big(0, KeysSize - 1);
+            return Keys[index];
+        }
+    
+        bytes encrypt(const bytes& msg, PESA& pesa) {
+            bytes res;
+            for (auto c : msg) res.push_back(pesa.enc(c));
+            return res;
+        }
+
+        bytes decrypt(const bytes& msg, PESA& pesa) {
+            bytes res;
+            for (auto c : msg) res.push_back((ubyte)pesa.dec(c));
+            return res;
+        }
+    };
+};
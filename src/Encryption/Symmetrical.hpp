@@ -42,21 +42,10 @@ namespace PulsarCrypto {
             }
         };
 
-        big random_symkey() {
-            auto index = random_big(0, KeysSize - 1);
-            return Keys[index];
-        }
+        big random_symkey();
     
-        bytes encrypt(const bytes& msg, PESA& pesa) {
-            bytes res;
-            for (auto c : msg) res.push_back(pesa.enc(c));
-            return res;
-        }
-
-        bytes decrypt(const bytes& msg, PESA& pesa) {
-            bytes res;
-            for (auto c : msg) res.push_back((ubyte)pesa.dec(c));
-            return res;
-        }
+        bytes encrypt(const bytes& msg, PESA& pesa);
+
+        bytes decrypt(const bytes& msg, PESA& pesa);
     };
 };
\ No newline at end of file
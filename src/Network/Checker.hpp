@@ -5,6 +5,15 @@
 
 #include "../defines"
 #include <string>
+#include <string_view>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#   include <emmintrin.h>
+#endif
 
 #define PULSAR_CHECKER_VERSION "0.0.1"
 
@@ -34,68 +43,153 @@ namespace Checker {
 
     /// @return Current version of Checker
     /// @warning If this doesn't matches the server version, the client should be closed immediatly
-    const static std::string version() { return PULSAR_CHECKER_VERSION; }
+    inline const std::string version() { return PULSAR_CHECKER_VERSION; }
 
     // Username
     using Username = const std::string&;
-    char username_blocked_symbols[] = {
+    inline constexpr char username_blocked_symbols[] = {
         ' ', '!', '#', '$', '%', '^', '&', '*', '(', ')',
         '-', '=', '+', '[', ']', '{', '}', '`', '~', '\047',
         '"', '<', '>', '?', ',', '.', '/', '|', '\\', ':', ';'
     };
 
-    std::string username_blocked[] = {
+    inline constexpr std::string_view username_blocked[] = {
         "@admin", "@browser", "@server", "@all"
     };
 
-    bool checkUsername(Username username) {
-        if (username[0] != '@') return false;
-        if (username.size() > PULSAR_USERNAME_SIZE) return false;
-
-        for (int i = 0; i < sizeof(username_blocked_symbols) / sizeof(char); i++) {
-            if (username.find(username_blocked_symbols[i]) != std::string::npos) return false;
-        }
-
-        for (int i = 0; i < sizeof(username_blocked) / sizeof(std::string); i++) {
-            if (username == username_blocked[i]) return false;
-        }
-
-        for (auto i : username) {
-            if (i != tolower(i)) return false;
-        }
-
-        return true;
-    }
-
     // Channels
     using Channel = const std::string&;
-    char channel_blocked_symbols[] = {
+    inline constexpr char channel_blocked_symbols[] = {
         ' ', '!', '@', '#', '$', '%', '^', '&', '*', '(', ')',
         '-', '=', '+', '[', ']', '{', '}', '`', '~', '\047',
         '"', '<', '>', '?', ',', '.', '/', '|', '\\', ';'
     };
 
-    std::string channel_blocked[] = {
+    inline constexpr std::string_view channel_blocked[] = {
         ":server", ":browser"
     };
 
-    bool checkChannelName(Channel channel) {
-        if (channel[0] != ':') return false;
-        if (channel.size() > PULSAR_USERNAME_SIZE) return false;
+    // Everything below is derived from the lists above at compile time
+    namespace detail {
+        enum : uint8_t {
+            BlockedInUsername = 1 << 0,
+            BlockedInChannel  = 1 << 1
+        };
+
+        // Character classes for all 256 byte values.
+        // Also blocked is everything the old `c != tolower(c)` check rejected with glibc in the "C" locale:
+        // upper case ASCII and bytes 0x80..0xFE (tolower of a negative char returns it unsigned,
+        // except for 0xFF which is EOF).
+        constexpr std::array<uint8_t, 256> make_classes() {
+            std::array<uint8_t, 256> table {};
+            for (char c : username_blocked_symbols) table[(unsigned char)c] |= BlockedInUsername;
+            for (char c : channel_blocked_symbols) table[(unsigned char)c] |= BlockedInChannel;
+            for (int c = 'A'; c <= 'Z'; c++) table[c] |= BlockedInUsername | BlockedInChannel;
+            for (int c = 0x80; c <= 0xFE; c++) table[c] |= BlockedInUsername | BlockedInChannel;
+            return table;
+        }
 
-        for (int i = 0; i < sizeof(channel_blocked_symbols) / sizeof(char); i++) {
-            if (channel.find(channel_blocked_symbols[i]) != std::string::npos) return false;
+        inline constexpr auto classes = make_classes();
+
+        static_assert(classes[0] == 0, "zero padding must not be blocked");
+
+        // The same classes as a list of [lo, hi] byte ranges, for the SSE2 path
+        struct Ranges {
+            uint8_t lo[16] {}, hi[16] {};
+            size_t count = 0;
+        };
+
+        constexpr Ranges make_ranges(uint8_t cls) {
+            Ranges r;
+            for (int c = 0; c < 256; c++) {
+                if (!(classes[c] & cls)) continue;
+                if (r.count && r.hi[r.count - 1] + 1 == c) r.hi[r.count - 1] = (uint8_t)c;
+                else {
+                    if (r.count == 16) throw "Checker: too many blocked ranges";
+                    r.lo[r.count] = r.hi[r.count] = (uint8_t)c;
+                    r.count++;
+                }
+            }
+            return r;
         }
 
-        for (int i = 0; i < sizeof(channel_blocked) / sizeof(std::string); i++) {
-            if (channel == channel_blocked[i]) return false;
+        static_assert(PULSAR_USERNAME_SIZE <= 32, "SSE2 path checks at most 32 bytes");
+
+        // Perfect hash over reserved names. Collisions fail at compile time.
+        constexpr size_t reserved_hash(std::string_view s) {
+            return (s.size() + (unsigned char)s.back()) % 16;
         }
 
-        for (auto i : channel) {
-            if (i != tolower(i)) return false;
+        struct ReservedSet {
+            std::string_view slots[16] {};
+
+            template <size_t N>
+            constexpr ReservedSet(const std::string_view (&names)[N]) {
+                for (auto name : names) {
+                    auto& slot = slots[reserved_hash(name)];
+                    if (!slot.empty()) throw "Checker: reserved name hash collision";
+                    slot = name;
+                }
+            }
+
+            constexpr bool contains(std::string_view s) const {
+                return !s.empty() && slots[reserved_hash(s)] == s;
+            }
+        };
+
+        inline constexpr ReservedSet reserved_usernames { username_blocked };
+        inline constexpr ReservedSet reserved_channels { channel_blocked };
+
+        /// @param str At most PULSAR_USERNAME_SIZE bytes
+        /// @return true if any byte of `str` is in the class
+        template <uint8_t cls>
+        inline bool has_blocked(std::string_view str) {
+#if defined(__SSE2__) || defined(_M_X64)
+            static constexpr Ranges ranges = make_ranges(cls);
+            alignas(16) unsigned char buf[32] = {};
+            std::memcpy(buf, str.data(), str.size());
+
+            __m128i lo = _mm_load_si128(reinterpret_cast<const __m128i*>(buf));
+            __m128i hi = _mm_load_si128(reinterpret_cast<const __m128i*>(buf + 16));
+            __m128i hits = _mm_setzero_si128();
+
+            // c in [lo, hi]  <=>  (uint8)(c - lo) <= hi - lo
+            for (size_t i = 0; i < ranges.count; i++) {
+                __m128i base = _mm_set1_epi8((char)ranges.lo[i]);
+                __m128i width = _mm_set1_epi8((char)(ranges.hi[i] - ranges.lo[i]));
+
+                __m128i d_lo = _mm_sub_epi8(lo, base);
+                __m128i d_hi = _mm_sub_epi8(hi, base);
+                hits = _mm_or_si128(hits, _mm_cmpeq_epi8(_mm_min_epu8(d_lo, width), d_lo));
+                hits = _mm_or_si128(hits, _mm_cmpeq_epi8(_mm_min_epu8(d_hi, width), d_hi));
+            }
+
+            return _mm_movemask_epi8(hits) != 0;
+#else
+            for (unsigned char c : str) {
+                if (classes[c] & cls) return true;
+            }
+            return false;
+#endif
         }
+    };
+
+    inline bool checkUsername(Username username) {
+        if (username[0] != '@') return false;
+        if (username.size() > PULSAR_USERNAME_SIZE) return false;
+
+        if (detail::has_blocked<detail::BlockedInUsername>(username)) return false;
+
+        return !detail::reserved_usernames.contains(username);
+    }
+
+    inline bool checkChannelName(Channel channel) {
+        if (channel[0] != ':') return false;
+        if (channel.size() > PULSAR_USERNAME_SIZE) return false;
+
+        if (detail::has_blocked<detail::BlockedInChannel>(channel)) return false;
 
-        return true;
+        return !detail::reserved_channels.contains(channel);
     }
 };
 
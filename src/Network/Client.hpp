@@ -12,12 +12,14 @@
 #include "../Graphics/Window.hpp"
 #include "../Other/Message.hpp"
 #include "../Console/Console.hpp"
+#include "../Console/Terminal.hpp"
 #include "../API/PulsarAPI.hpp"
+#include "../Other/StageGraph.hpp"
 #include <memory>
 
 class Client {
 private:
-    std::string name, password;
+    std::string name, password, password_unhashed;
     std::string ip;
     unsigned short port;
 
@@ -29,19 +31,15 @@ private:
     std::string dest = ":all";
 public:
     Client(const std::string& name, const std::string& password_unhashed, const std::string& ip, unsigned short port)
-     : ip(ip), port(port), name(name), password(hash(password_unhashed)) {
-        api = std::make_shared<PulsarAPI>(socket, name);
-        console = std::make_unique<Console>(api, dest, this->name);
-    }
+     : ip(ip), port(port), name(name), password_unhashed(password_unhashed) {}
 
     ~Client() {
-        api->disconnect();
+        if (api) api->disconnect();
     }
 
-    void run() {
-        if (!api->connect(ip, port)) return;
-        api->startRecieverLoop();
-        
+private:
+    // Returns false if the user is not logged in and the client should exit
+    bool logIn() {
         auto login = api->login(password);
 
         switch (login) {
@@ -49,7 +47,7 @@ public:
 
             case PulsarAPI::Fail_Password: {
                 std::cout << "Ошибка входа: неправильный пароль." << std::endl;
-                return;
+                return false;
             } break;
 
             case PulsarAPI::Fail_Username: {
@@ -59,37 +57,106 @@ public:
                 char ans = ans_[0];
                 ans = ::tolower(ans);
 
-                if (ans == 'n' || ans == '\n') return;
+                if (ans == 'n' || ans == '\n') return false;
                 else if (ans == 'y') {
                     api->registerUser(password);
                     break;
                 }
-                else return;
+                else return false;
             } break;
 
             case PulsarAPI::Fail_Unknown: {
                 std::cout << "Ошибка входа: неизвестная ошибка." << std::endl;
             } break;
         }
+        return true;
+    }
 
-        api->requestUnread();
+public:
+    void run() {
+        auto link = std::make_shared<PollableSocket>();
+
+        // Hashing the password, opening the database and connecting do not depend on each other.
+        // Unread messages saved last time are counted as soon as the database is open.
+        StageGraph startup { "startup" };
+        startup.add("hash", {}, [&] {
+            password = hash(password_unhashed);
+            return true;
+        });
+        startup.add("database", {}, [&] {
+            api = std::make_shared<PulsarAPI>(socket, name);
+            console = std::make_unique<Console>(api, dest, this->name);
+            return true;
+        });
+        startup.add("cache", { "database" }, [&] {
+            if (auto saved = api->getUnreadCount()) std::cout << "Непрочитанных сообщений с прошлого раза: " << saved << std::endl;
+            return true;
+        });
+        startup.add("connect", {}, [&] {
+            if (PulsarAPI::dial(*link, ip, port)) return true;
+            std::cout << "Невозможно подключиться к " << ip << ":" << port << std::endl;
+            std::cout << "Удостоверьтесь, что сервер работает и доступен." << std::endl;
+            return false;
+        });
+        startup.add("attach", { "database", "connect" }, [&] {
+            if (!api->attach(link, ip, port)) return false;
+            api->startRecieverLoop();
+            return true;
+        });
+        // after "cache" only to keep its output apart from the registration prompt
+        startup.add("login", { "attach", "hash", "cache" }, [&] { return logIn(); });
+        startup.add("unread", { "login" }, [&] {
+            api->requestUnread();
+            return true;
+        });
+
+        bool started = startup.run();
+#ifdef PULSAR_DEBUG
+        startup.report(std::cout);
+#endif
+        if (!started) return;
+
+        api->setAutoReconnect(true);
 
         std::cout << "Вы вошли в Pulsar как " << name << "." << std::endl;
         
         console->displayUnreadMessages();
 
+        Terminal term;
+        api->setMessageHandler([&term](const Message& msg) {
+            term.print(stringify(msg));
+        });
+
         std::string message;
-        while (api->isConnected()) {
-            std::cout << "[" << name << "](" << dest << "): ";
-            std::getline(std::cin, message);
+        while (api->isConnected() || api->isReconnecting()) {
+            term.setPrompt("[" + name + "](" + dest + "): ");
+
+            auto event = term.poll(message, 100);
+            if (event == Terminal::Eof) {
+                api->disconnect();
+                break;
+            }
+            if (event != Terminal::Line) continue;
 
             if (message[0] == '!') {
+                Terminal::Suspend suspend(term);
                 console->run(message);
                 continue;
             }
+            if (message.size() > PULSAR_MSG_SIZE) {
+                // one payload would be cut by the server, a transfer arrives whole
+                Terminal::Suspend suspend(term);
+                if (dest[0] != '@') std::cout << "Сообщение длиннее " << PULSAR_MSG_SIZE << " байт можно отправить только пользователю." << std::endl;
+                else if (message.size() > PULSAR_TRANSFER_TEXT_MAX_BYTES) std::cout << "Сообщение слишком длинное, отправьте его файлом: !send" << std::endl;
+                else {
+                    api->sendLong(dest, message);
+                    std::cout << "Сообщение длиннее " << PULSAR_MSG_SIZE << " байт отправляется по частям." << std::endl;
+                }
+                continue;
+            }
             if (!message.empty()) api->send(message, dest);
-
-            sf::sleep(sf::milliseconds(20));
         }
+
+        api->setMessageHandler(nullptr);
     }
 };
\ No newline at end of file
@@ -4,27 +4,152 @@
 #include "../Other/Message.hpp"
 #include "../defines"
 #include "SQLite3.hpp"
+#include "HistoryStore.hpp"
+#include "../Other/FlatMap.hpp"
 #include <string>
 #include <vector>
 #include <sstream>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <algorithm>
+#include <limits>
+#include <optional>
+
+class Database : public HistoryStore {
+public:
+    /// What is known of a partly received file, the bytes themselves are in its .part file
+    struct PartialTransfer {
+        std::string peer, id, name;
+        size_t size = 0, chunk = 0;
+        size_t next = 0;            // every chunk below it was received
+        std::string have;           // which of the ones after it were, a bitmap in hex
+    };
 
-class Database {
 private:
     SQLite3Database db;
     std::string username;
+
+    // Write-through copies of the channels and contacts tables: they are tiny and change only
+    // through join/leave/add_contact/remove_contact, so SQLite is read once at startup
+    std::shared_mutex cache_mtx;
+    FlatMap<bool> channels;
+    FlatMap<std::string> contacts;
+
+    // Copy of the unread_counts table, kept in step through RETURNING of the statements that change unread
+    FlatMap<size_t> unread_counts;
+    size_t unread_total = 0;
+
+    // cache_mtx must be held
+    void count_unread(const std::string& chat, int delta) {
+        auto count = unread_counts.find(chat);
+        size_t n = (count ? *count : 0) + delta;
+        if (n == 0) unread_counts.erase(chat);
+        else unread_counts.insert_or_assign(chat, n);
+        unread_total += delta;
+    }
+
+    static Message row_message(const SQLite3Database::Row& row) {
+        return Message { std::stoull(row[0]), static_cast<time_t>(std::stoull(row[1])), row[2], row[3], row[4] };
+    }
 public:
     Database(const std::string& username)
      : db(("pulsar_" + username + ".db")), username(username) {
         db.execute("PRAGMA foreign_keys = ON;");
-        db.execute("CREATE TABLE IF NOT EXISTS profile (username TEXT PRIMARY KEY, name TEXT, email TEXT, description TEXT, birthday INTEGER, status TEXT);");
-        db.execute("CREATE TABLE IF NOT EXISTS channels (username TEXT, channel TEXT, PRIMARY KEY(username, channel));");
-        db.execute("CREATE TABLE IF NOT EXISTS contacts (username TEXT, contact_username TEXT, contact_name TEXT, PRIMARY KEY(username, contact_username));");
-        db.execute("CREATE TABLE IF NOT EXISTS unread (username TEXT, id INTEGER, time INTEGER, src TEXT, dst TEXT, msg TEXT, PRIMARY KEY(username, id, src, dst));");
-        try {
-            db.execute("INSERT OR IGNORE INTO profile(username, name, email, description, birthday, status) VALUES ('" + username + "', 'NAME', '', '', 0, 'active');");
-        } catch(...) {}
+        migrate();
+        load_caches();
     }
 
+private:
+    void load_caches() {
+        std::unique_lock lk(cache_mtx);
+        db.query("SELECT channel FROM channels WHERE username='" + quote(username) + "';",
+                 [&](const SQLite3Database::Row& row){ channels.insert_or_assign(row[0], true); });
+        db.query("SELECT contact_username, contact_name FROM contacts WHERE username='" + quote(username) + "';",
+                 [&](const SQLite3Database::Row& row){ contacts.insert_or_assign(row[0], row[1]); });
+        db.query("SELECT chat, count FROM unread_counts WHERE username='" + quote(username) + "';",
+                 [&](const SQLite3Database::Row& row){
+                     unread_counts.insert_or_assign(row[0], std::stoull(row[1]));
+                     unread_total += std::stoull(row[1]);
+                 });
+    }
+
+    int user_version() {
+        int version = 0;
+        db.query("PRAGMA user_version;", [&](const SQLite3Database::Row& row){ version = std::stoi(row[0]); });
+        return version;
+    }
+
+    // Schema steps in order, PRAGMA user_version holds how many of them the file went through.
+    // A released step is never edited: change the schema by appending a new one.
+    // Files created before versioning are at 0 and already have some of the tables, hence IF NOT EXISTS in step 1.
+    void migrate() {
+        const std::string steps[] = {
+            // 1: initial schema
+            "CREATE TABLE IF NOT EXISTS profile (username TEXT PRIMARY KEY, name TEXT, email TEXT, description TEXT, birthday INTEGER, status TEXT);"
+            "CREATE TABLE IF NOT EXISTS channels (username TEXT, channel TEXT, PRIMARY KEY(username, channel));"
+            "CREATE TABLE IF NOT EXISTS contacts (username TEXT, contact_username TEXT, contact_name TEXT, PRIMARY KEY(username, contact_username));"
+            "CREATE TABLE IF NOT EXISTS unread (username TEXT, id INTEGER, time INTEGER, src TEXT, dst TEXT, msg TEXT, PRIMARY KEY(username, id, src, dst));"
+            "CREATE TABLE IF NOT EXISTS outbox (seq INTEGER PRIMARY KEY AUTOINCREMENT, username TEXT, time INTEGER, dst TEXT, msg TEXT);"
+            "CREATE TABLE IF NOT EXISTS last_seen (username TEXT, chat TEXT, id INTEGER, PRIMARY KEY(username, chat));"
+            "INSERT OR IGNORE INTO profile(username, name, email, description, birthday, status) VALUES ('" + quote(username) + "', 'NAME', '', '', 0, 'active');",
+
+            // 2: get_unread reads in time order, read() deletes by chat and id
+            "CREATE INDEX IF NOT EXISTS unread_by_time ON unread(username, time, id, src, dst, msg);"
+            "CREATE INDEX IF NOT EXISTS unread_by_chat ON unread(username, dst, id);",
+
+            // 3: per-chat read watermarks
+            "CREATE TABLE IF NOT EXISTS read_marks (username TEXT, chat TEXT, id INTEGER, PRIMARY KEY(username, chat));",
+
+            // 4: unread counts per chat, kept by triggers so startup does not count the unread table
+            "CREATE TABLE IF NOT EXISTS unread_counts (username TEXT, chat TEXT, count INTEGER, PRIMARY KEY(username, chat));"
+            "CREATE TRIGGER IF NOT EXISTS unread_counts_insert AFTER INSERT ON unread BEGIN "
+                "INSERT INTO unread_counts(username, chat, count) VALUES (NEW.username, NEW.dst, 1) "
+                "ON CONFLICT(username, chat) DO UPDATE SET count = count + 1; "
+            "END;"
+            "CREATE TRIGGER IF NOT EXISTS unread_counts_delete AFTER DELETE ON unread BEGIN "
+                "UPDATE unread_counts SET count = count - 1 WHERE username = OLD.username AND chat = OLD.dst; "
+                "DELETE FROM unread_counts WHERE username = OLD.username AND chat = OLD.dst AND count <= 0; "
+            "END;"
+            "INSERT OR REPLACE INTO unread_counts(username, chat, count) SELECT username, dst, COUNT(*) FROM unread GROUP BY username, dst;",
+
+            // 5: local message history with a full-text index over it (external content, so the text is stored once).
+            // The chat is indexed too, so filtering by it intersects posting lists instead of visiting every match; bm25 ranks by text only.
+            "CREATE TABLE IF NOT EXISTS history (username TEXT, chat TEXT, id INTEGER, time INTEGER, src TEXT, dst TEXT, msg TEXT, PRIMARY KEY(username, chat, id));"
+            "CREATE VIRTUAL TABLE IF NOT EXISTS history_fts USING fts5(msg, chat, content='history', content_rowid='rowid', tokenize='unicode61 remove_diacritics 2');"
+            "INSERT INTO history_fts(history_fts, rank) VALUES ('rank', 'bm25(1.0, 0.0)');"
+            "CREATE TRIGGER IF NOT EXISTS history_fts_insert AFTER INSERT ON history BEGIN "
+                "INSERT INTO history_fts(rowid, msg, chat) VALUES (NEW.rowid, NEW.msg, NEW.chat); "
+            "END;"
+            "CREATE TRIGGER IF NOT EXISTS history_fts_delete AFTER DELETE ON history BEGIN "
+                "INSERT INTO history_fts(history_fts, rowid, msg, chat) VALUES ('delete', OLD.rowid, OLD.msg, OLD.chat); "
+            "END;"
+            "CREATE TRIGGER IF NOT EXISTS history_fts_update AFTER UPDATE OF msg, chat ON history BEGIN "
+                "INSERT INTO history_fts(history_fts, rowid, msg, chat) VALUES ('delete', OLD.rowid, OLD.msg, OLD.chat); "
+                "INSERT INTO history_fts(rowid, msg, chat) VALUES (NEW.rowid, NEW.msg, NEW.chat); "
+            "END;"
+            "INSERT OR IGNORE INTO history(username, chat, id, time, src, dst, msg) "
+                "SELECT username, CASE WHEN dst = username THEN src ELSE dst END, id, time, src, dst, msg FROM unread;",
+
+            // 6: incoming file transfers cut short, resumed when the sender offers the same one again
+            "CREATE TABLE IF NOT EXISTS transfers (username TEXT, peer TEXT, id TEXT, name TEXT, size INTEGER, chunk INTEGER, next INTEGER, have TEXT, PRIMARY KEY(username, peer, id));",
+        };
+        const int latest = std::size(steps);
+
+        int version = user_version();
+        if (version > latest) return;     // written by a newer client, its additions are not ours to touch
+
+        for (; version < latest; version++) {
+            try {
+                db.execute("BEGIN;" + steps[version] + "PRAGMA user_version = " + std::to_string(version + 1) + ";COMMIT;");
+            } catch (...) {
+                try { db.execute("ROLLBACK;"); } catch (...) {}
+                throw;
+            }
+        }
+    }
+
+public:
     std::string getString() {
         return "sqlite3://pulsar_" + username + ".db";
     }
@@ -38,39 +163,45 @@ public:
     bool is_channel_member(const std::string& channel) {
         if (channel.empty()) return false;
         if (channel[0] == '@' || channel[0] == '!') return false;
-        bool exists = false;
-        db.query("SELECT 1 FROM channels WHERE username='" + username + "' AND channel='" + channel + "' LIMIT 1;",
-                 [&](const SQLite3Database::Row& row){ exists = true; });
-        return exists;
+        std::shared_lock lk(cache_mtx);
+        return channels.contains(channel);
     }
 
+    // The cache is updated under its lock together with the table, after the statement succeeded
     void join(const std::string& channel) {
+        std::unique_lock lk(cache_mtx);
         db.execute("INSERT OR IGNORE INTO channels(username, channel) VALUES ('" + username + "', '" + channel + "');");
+        channels.insert_or_assign(channel, true);
     }
 
     void leave(const std::string& channel) {
+        std::unique_lock lk(cache_mtx);
         db.execute("DELETE FROM channels WHERE username='" + username + "' AND channel='" + channel + "';");
+        channels.erase(channel);
     }
 
     void add_contact(const std::string& contact_username, const std::string& contact_name) {
+        std::unique_lock lk(cache_mtx);
         db.execute("INSERT OR REPLACE INTO contacts(username, contact_username, contact_name) VALUES ('" + username + "', '" + contact_username + "', '" + contact_name + "');");
+        contacts.insert_or_assign(contact_username, contact_name);
     }
 
     void remove_contact(const std::string& contact_username) {
+        std::unique_lock lk(cache_mtx);
         db.execute("DELETE FROM contacts WHERE username='" + username + "' AND contact_username='" + contact_username + "';");
+        contacts.erase(contact_username);
     }
 
     std::string contact_name(const std::string& contact_username) {
-        std::string res;
-        db.query("SELECT contact_name FROM contacts WHERE username='" + username + "' AND contact_username='" + contact_username + "' LIMIT 1;",
-                 [&](const SQLite3Database::Row& row){ res = row[0]; });
-        return res;
+        std::shared_lock lk(cache_mtx);
+        auto name = contacts.find(contact_username);
+        return name ? *name : std::string {};
     }
 
     Message contact(const Message& msg) {
         std::string cname = contact_name(msg.get_src());
         if (cname.empty()) return msg;
-        return Message(msg.get_id(), msg.get_time().toTime(), cname, msg.get_dst(), msg.get_msg());
+        return Message(msg.get_id(), msg.get_time().toTime(), Symbol(cname), msg.get_dst_symbol(), msg.get_msg());
     }
 
     void update_profile(const Profile& profile) {
@@ -79,33 +210,252 @@ public:
         db.execute(oss.str());
     }
 
+    /// Messages at or below the chat's read mark are already read and are not stored
     void store_unread(const Message& msg) {
         std::ostringstream oss;
-        oss << "INSERT OR REPLACE INTO unread(username, id, time, src, dst, msg) VALUES ('" << username << "', " << msg.get_id() << ", " << msg.get_time().toTime() << ", '" << msg.get_src() << "', '" << msg.get_dst() << "', '" << msg.get_msg() << "');";
-        db.execute(oss.str());
+        oss << "INSERT OR IGNORE INTO unread(username, id, time, src, dst, msg) SELECT '" << username << "', " << msg.get_id() << ", " << msg.get_time().toTime() << ", '" << quote(msg.get_src()) << "', '" << quote(msg.get_dst()) << "', '" << quote(msg.get_msg()) << "' "
+            << "WHERE NOT EXISTS (SELECT 1 FROM read_marks WHERE username='" << username << "' AND chat='" << quote(msg.get_dst()) << "' AND id>=" << msg.get_id() << ") RETURNING dst;";
+
+        std::unique_lock lk(cache_mtx);
+        db.query(oss.str(), [&](const SQLite3Database::Row& row){ count_unread(row[0], 1); });
     }
 
+    /// Every unread message, oldest first
     std::vector<Message> get_unread() {
         std::vector<Message> out;
         db.query("SELECT id, time, src, dst, msg FROM unread WHERE username='" + username + "' ORDER BY time ASC;",
-                 [&](const SQLite3Database::Row& row){
-                     size_t id = std::stoull(row[0]);
-                     time_t t = static_cast<time_t>(std::stoull(row[1]));
-                     std::string src = row[2];
-                     std::string dst = row[3];
-                     std::string text = row[4];
-                     out.emplace_back(id, t, src, dst, text);
-                 });
+                 [&](const SQLite3Database::Row& row){ out.push_back(row_message(row)); });
+        return out;
+    }
+
+    /// Unread messages of one chat, for when it is opened
+    std::vector<Message> get_unread(const std::string& chat) {
+        std::vector<Message> out;
+        db.query("SELECT id, time, src, dst, msg FROM unread WHERE username='" + username + "' AND dst='" + quote(chat) + "' ORDER BY id ASC;",
+                 [&](const SQLite3Database::Row& row){ out.push_back(row_message(row)); });
+        return out;
+    }
+
+    size_t unread_count(const std::string& chat) {
+        std::shared_lock lk(cache_mtx);
+        auto count = unread_counts.find(chat);
+        return count ? *count : 0;
+    }
+
+    size_t unread_count() {
+        std::shared_lock lk(cache_mtx);
+        return unread_total;
+    }
+
+    /// Chats with unread messages and how many there are in each
+    std::map<std::string, size_t> unread_by_chat() {
+        std::map<std::string, size_t> out;
+        std::shared_lock lk(cache_mtx);
+        unread_counts.for_each([&](const std::string& chat, size_t count) { out[chat] = count; });
         return out;
     }
 
     void read(const std::string& chat, size_t id) {
         std::ostringstream oss;
-        oss << "DELETE FROM unread WHERE username='" << username << "' AND id=" << id << " AND dst='" << chat << "';";
-        db.execute(oss.str());
+        oss << "DELETE FROM unread WHERE username='" << username << "' AND id=" << id << " AND dst='" << quote(chat) << "' RETURNING dst;";
+
+        std::unique_lock lk(cache_mtx);
+        db.query(oss.str(), [&](const SQLite3Database::Row& row){ count_unread(row[0], -1); });
+    }
+
+    /// Everything in `chat` up to and including `id` is read: one ranged DELETE and the chat's read mark goes up
+    void read_up_to(const std::string& chat, size_t id) {
+        std::ostringstream oss;
+        oss << "BEGIN;"
+            << "DELETE FROM unread WHERE username='" << username << "' AND dst='" << quote(chat) << "' AND id<=" << id << " RETURNING dst;"
+            << "INSERT INTO read_marks(username, chat, id) VALUES ('" << username << "', '" << quote(chat) << "', " << id << ") "
+            << "ON CONFLICT(username, chat) DO UPDATE SET id=MAX(id, excluded.id);"
+            << "COMMIT;";
+
+        std::unique_lock lk(cache_mtx);
+        db.query(oss.str(), [&](const SQLite3Database::Row& row){ count_unread(row[0], -1); });
+    }
+
+    /// Ids of unread messages in `chat` up to `id`, ascending
+    std::vector<size_t> unread_ids(const std::string& chat, size_t id) {
+        std::vector<size_t> out;
+        db.query("SELECT id FROM unread WHERE username='" + username + "' AND dst='" + quote(chat) + "' AND id<=" + std::to_string(id) + " ORDER BY id;",
+                 [&](const SQLite3Database::Row& row){ out.push_back(std::stoull(row[0])); });
+        return out;
+    }
+
+    /// Chats with unread messages and the newest unread id in each
+    std::map<std::string, size_t> unread_chats() {
+        std::map<std::string, size_t> out;
+        db.query("SELECT dst, MAX(id) FROM unread WHERE username='" + username + "' GROUP BY dst;",
+                 [&](const SQLite3Database::Row& row){ out[row[0]] = std::stoull(row[1]); });
+        return out;
     }
 
     void clear_unread() {
+        std::unique_lock lk(cache_mtx);
         db.execute("DELETE FROM unread WHERE username='" + username + "';");
+        unread_counts.clear();
+        unread_total = 0;
+    }
+
+    /// Keeps messages for search, in one transaction. A message already stored in its chat is skipped.
+    void store_history(const std::vector<Message>& msgs) override {
+        if (msgs.empty()) return;
+
+        std::ostringstream oss;
+        oss << "BEGIN;";
+        for (auto& msg : msgs) {
+            if (msg.get_id() == 0) continue;
+            auto& chat = chat_of(msg, username);
+            oss << "INSERT OR IGNORE INTO history(username, chat, id, time, src, dst, msg) VALUES ('" << username << "', '" << quote(chat) << "', "
+                << msg.get_id() << ", " << msg.get_time().toTime() << ", '" << quote(msg.get_src()) << "', '" << quote(msg.get_dst()) << "', '" << quote(msg.get_msg()) << "');";
+        }
+        oss << "COMMIT;";
+        db.execute(oss.str());
+    }
+
+    std::vector<Message> history(const std::string& chat, size_t before = std::numeric_limits<size_t>::max(), size_t limit = 50) override {
+        std::vector<Message> out;
+        db.query("SELECT id, time, src, dst, msg FROM history WHERE username='" + username + "' AND chat='" + quote(chat) + "' AND id<" + std::to_string(std::min<size_t>(before, INT64_MAX))
+                 + " ORDER BY id DESC LIMIT " + std::to_string(limit) + ";",
+                 [&](const SQLite3Database::Row& row){ out.push_back(row_message(row)); });
+        std::reverse(out.begin(), out.end());
+        return out;
+    }
+
+    /// Every word of `text` has to occur, a word ending with '*' is a prefix. FTS5 operators are not interpreted.
+    static std::string match_expression(const std::string& text) {
+        std::string res;
+        std::istringstream words(text);
+        std::string word;
+        while (words >> word) {
+            bool prefix = word.size() > 1 && word.back() == '*';
+            if (prefix) word.pop_back();
+
+            if (!res.empty()) res += ' ';
+            res += '"';
+            for (auto c : word) {
+                if (c == '"') res += '"';
+                res += c;
+            }
+            res += prefix ? "\"*" : "\"";
+        }
+        return res;
+    }
+
+    /// Stored messages matching `text`, empty `chat` searches all chats.
+    /// The newest PULSAR_SEARCH_RANKED matches come best first (bm25), older ones after them from newest to oldest:
+    /// ranking every match of a common word would cost far more than reading a page of them.
+    std::vector<Message> search(const std::string& text, const std::string& chat = "", size_t limit = 20, size_t offset = 0) {
+        std::vector<Message> out;
+        auto expression = match_expression(text);
+        if (expression.empty()) return out;
+
+        expression = "msg : (" + expression + ")";
+        if (!chat.empty()) {
+            // the whole name as one phrase: ":general" is the token "general", "@ivan_petrov" the phrase "ivan petrov"
+            expression += " AND chat : \"";
+            for (auto c : chat) {
+                if (c == '"') expression += '"';
+                expression += c;
+            }
+            expression += '"';
+        }
+
+        auto select = [&](const std::string& matches, const char* order) {
+            std::ostringstream oss;
+            oss << "SELECT h.id, h.time, h.src, h.dst, h.msg FROM (" << matches << ") f JOIN history h ON h.rowid = f.rowid "
+                << "WHERE h.username='" << username << "'";
+            // the index only knows the chat's words, the exact name is checked here
+            if (!chat.empty()) oss << " AND h.chat='" << quote(chat) << "'";
+            oss << " ORDER BY " << order << ";";
+            db.query(oss.str(), [&](const SQLite3Database::Row& row){ out.push_back(row_message(row)); });
+        };
+        auto newest = "SELECT rowid, rank FROM history_fts WHERE history_fts MATCH '" + quote(expression) + "' ORDER BY rowid DESC";
+
+        const size_t ranked = PULSAR_SEARCH_RANKED;
+        if (offset < ranked) {
+            size_t n = std::min(limit, ranked - offset);
+            select("SELECT rowid, rank FROM (" + newest + " LIMIT " + std::to_string(ranked) + ") ORDER BY rank LIMIT "
+                + std::to_string(n) + " OFFSET " + std::to_string(offset), "f.rank");
+            limit -= n;
+            offset = ranked;
+        }
+        if (limit > 0) {
+            select(newest + " LIMIT " + std::to_string(limit) + " OFFSET " + std::to_string(offset), "f.rowid DESC");
+        }
+        return out;
+    }
+
+    // Doubles single quotes for a string literal, message text may contain anything
+    static std::string quote(const std::string& text) {
+        std::string res;
+        for (auto c : text) {
+            if (c == '\'') res.push_back('\'');
+            res.push_back(c);
+        }
+        return res;
+    }
+
+    /// Keeps a message typed while offline until the connection is back
+    void queue_outgoing(const Message& msg) {
+        std::ostringstream oss;
+        oss << "INSERT INTO outbox(username, time, dst, msg) VALUES ('" << username << "', " << msg.get_time().toTime() << ", '" << quote(msg.get_dst()) << "', '" << quote(msg.get_msg()) << "');";
+        db.execute(oss.str());
+    }
+
+    /// Queued messages in the order they were typed, paired with their outbox seq
+    std::vector<std::pair<int64_t, Message>> get_outbox() {
+        std::vector<std::pair<int64_t, Message>> out;
+        db.query("SELECT seq, time, dst, msg FROM outbox WHERE username='" + username + "' ORDER BY seq ASC;",
+                 [&](const SQLite3Database::Row& row){
+                     time_t t = static_cast<time_t>(std::stoll(row[1]));
+                     out.emplace_back(std::stoll(row[0]), Message { 0, t, username, row[2], row[3] });
+                 });
+        return out;
+    }
+
+    /// Drops every queued message up to and including `seq`
+    void remove_outbox(int64_t seq) {
+        db.execute("DELETE FROM outbox WHERE username='" + username + "' AND seq<=" + std::to_string(seq) + ";");
+    }
+
+    std::map<std::string, size_t> get_last_seen() {
+        std::map<std::string, size_t> out;
+        db.query("SELECT chat, id FROM last_seen WHERE username='" + username + "';",
+                 [&](const SQLite3Database::Row& row){ out[row[0]] = std::stoull(row[1]); });
+        return out;
+    }
+
+    /// Stores the newest message id per chat in one transaction
+    void save_last_seen(const std::map<std::string, size_t>& seen) {
+        if (seen.empty()) return;
+
+        std::ostringstream oss;
+        oss << "BEGIN;";
+        for (auto& [chat, id] : seen) {
+            oss << "INSERT OR REPLACE INTO last_seen(username, chat, id) VALUES ('" << username << "', '" << quote(chat) << "', " << id << ");";
+        }
+        oss << "COMMIT;";
+        db.execute(oss.str());
+    }
+
+    void save_transfer(const PartialTransfer& t) {
+        std::ostringstream oss;
+        oss << "INSERT OR REPLACE INTO transfers(username, peer, id, name, size, chunk, next, have) VALUES ('" << username << "', '" << quote(t.peer) << "', '"
+            << quote(t.id) << "', '" << quote(t.name) << "', " << t.size << ", " << t.chunk << ", " << t.next << ", '" << t.have << "');";
+        db.execute(oss.str());
+    }
+
+    std::optional<PartialTransfer> load_transfer(const std::string& peer, const std::string& id) {
+        std::optional<PartialTransfer> out;
+        db.query("SELECT name, size, chunk, next, have FROM transfers WHERE username='" + username + "' AND peer='" + quote(peer) + "' AND id='" + quote(id) + "';",
+                 [&](const SQLite3Database::Row& row){ out = PartialTransfer { peer, id, row[0], std::stoull(row[1]), std::stoull(row[2]), std::stoull(row[3]), row[4] }; });
+        return out;
+    }
+
+    void remove_transfer(const std::string& peer, const std::string& id) {
+        db.execute("DELETE FROM transfers WHERE username='" + username + "' AND peer='" + quote(peer) + "' AND id='" + quote(id) + "';");
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../defines"
+#include "../Other/Message.hpp"
+#include <limits>
+#include <string>
+#include <vector>
+
+// Where PulsarAPI keeps the messages it has seen: the SQLite Database (searchable),
+// or a MessageLog for bridges that ingest faster than SQLite can insert.
+class HistoryStore {
+public:
+    virtual ~HistoryStore() = default;
+
+    /// Keeps messages; one already stored in its chat is not stored again (or is dropped later)
+    virtual void store_history(const std::vector<Message>& msgs) = 0;
+
+    /// Up to `limit` newest messages of `chat` with ids below `before`, oldest first
+    virtual std::vector<Message> history(const std::string& chat, size_t before = std::numeric_limits<size_t>::max(), size_t limit = 50) = 0;
+
+    /// The chat a stored message belongs to: a direct message is kept under the other user
+    static const std::string& chat_of(const Message& msg, const std::string& username) {
+        return msg.get_dst() == username ? msg.get_src() : msg.get_dst();
+    }
+};
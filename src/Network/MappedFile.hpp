@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+// View of the beginning of a file, unmapped when the last user lets go of it
+class FileMapping {
+private:
+    char* base = nullptr;
+    size_t length = 0;
+public:
+    FileMapping(char* base, size_t length) : base(base), length(length) {}
+
+    ~FileMapping() {
+        if (!base) return;
+#ifdef _WIN32
+        UnmapViewOfFile(base);
+#else
+        munmap(base, length);
+#endif
+    }
+
+    FileMapping(const FileMapping&) = delete;
+    FileMapping& operator=(const FileMapping&) = delete;
+
+    const char* data() const { return base; }
+    char* data() { return base; }       // writable mappings only, see MappedFile::mapWritable()
+    size_t size() const { return length; }
+
+    /// Writes the changed pages of a writable mapping to the file
+    bool flush() {
+        if (!base) return true;
+#ifdef _WIN32
+        return FlushViewOfFile(base, length) != 0;
+#else
+        return msync(base, length, MS_SYNC) == 0;
+#endif
+    }
+};
+
+// File written with positioned writes or through a writable mapping, and read through mappings of it
+class MappedFile {
+public:
+    enum Access {
+        ReadWrite,      // created if missing
+        ReadOnly
+    };
+
+private:
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+    std::filesystem::path path;
+
+    [[noreturn]] void fail(const char* what) const {
+        throw std::runtime_error(std::string("MappedFile: ") + what + " failed for " + path.string());
+    }
+
+public:
+    explicit MappedFile(std::filesystem::path file, Access access = ReadWrite) : path(std::move(file)) {
+#ifdef _WIN32
+        if (access == ReadOnly) {
+            handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                 nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        } else {
+            handle = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                 nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        }
+        if (handle == INVALID_HANDLE_VALUE) fail("open");
+#else
+        if (access == ReadOnly) fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        else fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) fail("open");
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+#else
+        if (fd >= 0) ::close(fd);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const std::filesystem::path& getPath() const { return path; }
+
+    size_t size() const {
+#ifdef _WIN32
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(handle, &size)) fail("stat");
+        return (size_t)size.QuadPart;
+#else
+        struct stat st;
+        if (fstat(fd, &st) != 0) fail("stat");
+        return (size_t)st.st_size;
+#endif
+    }
+
+    void write(uint64_t offset, const char* data, size_t n) {
+        while (n > 0) {
+#ifdef _WIN32
+            OVERLAPPED at {};
+            at.Offset = (DWORD)offset;
+            at.OffsetHigh = (DWORD)(offset >> 32);
+            DWORD written = 0;
+            if (!WriteFile(handle, data, (DWORD)std::min<size_t>(n, 1 << 30), &written, &at)) fail("write");
+#else
+            ssize_t written = ::pwrite(fd, data, n, (off_t)offset);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                fail("write");
+            }
+#endif
+            data += written;
+            offset += written;
+            n -= written;
+        }
+    }
+
+    void sync() {
+#ifdef _WIN32
+        if (!FlushFileBuffers(handle)) fail("sync");
+#elif defined(__linux__)
+        if (fdatasync(fd) != 0) fail("sync");
+#else
+        if (fsync(fd) != 0) fail("sync");
+#endif
+    }
+
+    void truncate(size_t size) {
+#ifdef _WIN32
+        LARGE_INTEGER at;
+        at.QuadPart = (LONGLONG)size;
+        if (!SetFilePointerEx(handle, at, nullptr, FILE_BEGIN) || !SetEndOfFile(handle)) fail("truncate");
+#else
+        if (ftruncate(fd, (off_t)size) != 0) fail("truncate");
+#endif
+    }
+
+    /// Read-only view of the first `size` bytes, which must already be written. A `sequential` one
+    /// is read ahead; others fault in page by page, reads only touch a few pages of a footer.
+    std::shared_ptr<const FileMapping> map(size_t size, bool sequential = false) const {
+        if (size == 0) return std::make_shared<FileMapping>(nullptr, 0);
+#ifdef _WIN32
+        HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) fail("mmap");
+        auto base = (char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+        CloseHandle(mapping);       // the view keeps the mapping alive
+        if (!base) fail("mmap");
+#else
+        auto base = (char*)mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) fail("mmap");
+        madvise(base, size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+#endif
+        return std::make_shared<FileMapping>(base, size);
+    }
+
+    /// Shared writable view of the first `size` bytes, the file is extended to them first.
+    /// Stores into it reach the file without a write() call, flush() makes them durable.
+    std::shared_ptr<FileMapping> mapWritable(size_t size) {
+        if (this->size() < size) truncate(size);
+        if (size == 0) return std::make_shared<FileMapping>(nullptr, 0);
+#ifdef _WIN32
+        HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+        if (!mapping) fail("mmap");
+        auto base = (char*)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+        CloseHandle(mapping);
+        if (!base) fail("mmap");
+#else
+        auto base = (char*)mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) fail("mmap");
+#endif
+        return std::make_shared<FileMapping>(base, size);
+    }
+};
@@ -0,0 +1,542 @@
+#pragma once
+
+#include "../defines"
+#include "../Other/FlatMap.hpp"
+#include "../Other/Message.hpp"
+#include "../Other/Symbol.hpp"
+#include "../Other/Metrics.hpp"
+#include "../Other/Trace.hpp"
+#include "../lib/hash.h"
+#include "HistoryStore.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Append-only history in segment files of encoded messages, for bridges that ingest every channel:
+// appending is a write() per batch of callers (group commit, one fsync each), where SQLite pays a
+// transaction with its index and full-text updates.
+//
+// <seq>.log holds records back to back. When it reaches PULSAR_LOG_SEGMENT_BYTES it is sealed:
+// a footer lists, for every chat, the (id, offset) of its records sorted by id, and ends with a
+// directory of the chats. Opening reads only the directories, reads binary-search the mapped footers.
+// A background thread merges PULSAR_LOG_COMPACT_SEGMENTS sealed segments of about the same size into one,
+// dropping duplicates and storing every chat's records together, so reading a chat touches few pages.
+// The active segment is sealed on close too; after a crash it is cut at its first incomplete record.
+class MessageLog : public HistoryStore {
+private:
+    static constexpr uint64_t magic = 0x31474F4C52534C50;      // "PLSRLOG1"
+
+    // Followed by chat, src, dst and the text; records are padded to 8 bytes
+    struct Record {
+        uint32_t size;          // of the whole record, header and padding included
+        uint32_t checksum;      // fnv1a of everything after this field
+        uint64_t id;
+        int64_t time;
+        uint16_t chat_size, src_size, dst_size, padding;
+    };
+    static_assert(sizeof(Record) == 32);
+
+    struct Entry {
+        uint64_t id;
+        uint64_t offset;
+    };
+
+    // Records of one chat in one sealed segment, the entries point into the mapped footer
+    struct Range {
+        uint64_t min_id = 0, max_id = 0;
+        const Entry* entries = nullptr;
+        size_t count = 0;
+    };
+
+    struct Segment {
+        uint64_t seq;
+        std::unique_ptr<MappedFile> file;
+        std::shared_ptr<const FileMapping> mapping;
+        size_t end = 0;                 // bytes of records
+        FlatMap<Range> chats;           // sealed segments only
+    };
+
+    // Messages of the callers waiting for the same write
+    struct Batch {
+        std::string bytes;
+        std::vector<std::pair<Symbol, Entry>> entries;          // offsets relative to the batch
+        std::exception_ptr error;
+        bool done = false;
+    };
+
+    std::filesystem::path dir;
+    std::string username;
+    size_t segment_bytes;
+
+    std::shared_mutex mtx;                                  // segments, active and its index
+    std::vector<std::shared_ptr<Segment>> sealed;
+    std::shared_ptr<Segment> active;
+    FlatMap<std::vector<Entry>> active_index;
+    uint64_t next_seq = 1;
+
+    std::mutex commit_mtx;
+    std::condition_variable commit_cv;
+    std::shared_ptr<Batch> filling = std::make_shared<Batch>();
+    bool committing = false;
+
+    std::mutex compact_mtx;
+    std::condition_variable compact_cv;
+    bool compact_wanted = false, stopping = false;
+    std::thread compactor;
+
+    static size_t padded(size_t n) { return (n + 7) & ~size_t(7); }
+
+    static uint32_t checksum(const char* record, size_t size) {
+        return fnv1a(std::string_view(record + 8, size - 8));
+    }
+
+    std::filesystem::path segmentPath(uint64_t seq, const char* suffix = ".log") const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llu%s", (unsigned long long)seq, suffix);
+        return dir / name;
+    }
+
+    static void encode(std::string& out, const std::string& chat, const Message& msg) {
+        size_t unpadded = sizeof(Record) + chat.size() + msg.get_src().size() + msg.get_dst().size() + msg.get_msg().size();
+        size_t size = padded(unpadded);
+        size_t at = out.size();
+        out.resize(at + size);
+
+        Record r {};
+        r.size = (uint32_t)size;
+        r.id = msg.get_id();
+        r.time = msg.get_time().toTime();
+        r.chat_size = (uint16_t)chat.size();
+        r.src_size = (uint16_t)msg.get_src().size();
+        r.dst_size = (uint16_t)msg.get_dst().size();
+        r.padding = (uint16_t)(size - unpadded);
+
+        char* p = out.data() + at + sizeof(Record);
+        for (auto* s : { &chat, &msg.get_src(), &msg.get_dst(), &msg.get_msg() }) {
+            std::memcpy(p, s->data(), s->size());
+            p += s->size();
+        }
+        std::memcpy(out.data() + at, &r, sizeof(r));
+        r.checksum = checksum(out.data() + at, size);
+        std::memcpy(out.data() + at + 4, &r.checksum, sizeof(r.checksum));
+    }
+
+    // Record at `offset` if it is whole and intact, for recovery
+    static const Record* validRecord(const char* base, size_t end, size_t offset) {
+        if (end - offset < sizeof(Record)) return nullptr;
+        auto r = (const Record*)(base + offset);
+        if (r->size < sizeof(Record) || r->size % 8 || r->size > end - offset) return nullptr;
+        if ((size_t)r->chat_size + r->src_size + r->dst_size + r->padding > r->size - sizeof(Record)) return nullptr;
+        if (checksum(base + offset, r->size) != r->checksum) return nullptr;
+        return r;
+    }
+
+    static std::string_view recordChat(const char* base, uint64_t offset) {
+        auto r = (const Record*)(base + offset);
+        return { base + offset + sizeof(Record), r->chat_size };
+    }
+
+    static Message decode(const char* base, uint64_t offset) {
+        auto r = (const Record*)(base + offset);
+        const char* p = base + offset + sizeof(Record) + r->chat_size;
+        std::string_view src(p, r->src_size);
+        std::string_view dst(p + r->src_size, r->dst_size);
+        p += r->src_size + r->dst_size;
+        std::string_view text(p, base + offset + r->size - r->padding - p);
+        return Message(r->id, (time_t)r->time, src, dst, std::string(text));
+    }
+
+    // Opening a segment reads only the directory at its end, the entries are touched by the reads that need them
+    struct DirectoryEntry {
+        uint64_t entries;       // offset of the chat's entries
+        uint64_t min_id, max_id;
+        uint32_t count;
+        uint32_t name_size;     // followed by the name, padded to 8 bytes
+    };
+
+    struct Trailer {
+        uint64_t records_end;
+        uint64_t directory;
+        uint64_t chats;
+        uint64_t magic;
+    };
+
+    // Footer: the entries of every chat, its directory entry of each chat, a Trailer
+    static std::string footer(const FlatMap<std::vector<Entry>>& index, size_t records_end) {
+        std::string entries, directory;
+        uint64_t chats = 0;
+        index.for_each([&](const std::string& chat, const std::vector<Entry>& list) {
+            DirectoryEntry d { records_end + entries.size(), 0, 0, (uint32_t)list.size(), (uint32_t)chat.size() };
+            if (!list.empty()) {
+                d.min_id = list.front().id;
+                d.max_id = list.back().id;
+            }
+            entries.append((const char*)list.data(), list.size() * sizeof(Entry));
+            directory.append((const char*)&d, sizeof(d));
+            directory.append(chat);
+            directory.resize(padded(directory.size()));
+            chats++;
+        });
+        Trailer trailer { records_end, records_end + entries.size(), chats, magic };
+        return entries + directory + std::string((const char*)&trailer, sizeof(trailer));
+    }
+
+    static bool isSealed(const char* base, size_t size) {
+        if (size < sizeof(Trailer)) return false;
+        Trailer trailer;
+        std::memcpy(&trailer, base + size - sizeof(trailer), sizeof(trailer));
+        return trailer.magic == magic && trailer.records_end <= trailer.directory && trailer.directory <= size - sizeof(trailer);
+    }
+
+    static std::shared_ptr<Segment> openSealed(uint64_t seq, std::unique_ptr<MappedFile> file, size_t size) {
+        auto seg = std::make_shared<Segment>();
+        seg->seq = seq;
+        seg->mapping = file->map(size);
+        seg->file = std::move(file);
+
+        const char* base = seg->mapping->data();
+        Trailer trailer;
+        std::memcpy(&trailer, base + size - sizeof(trailer), sizeof(trailer));
+        seg->end = trailer.records_end;
+
+        size_t at = trailer.directory;
+        for (uint64_t i = 0; i < trailer.chats; i++) {
+            auto d = (const DirectoryEntry*)(base + at);
+            std::string_view chat(base + at + sizeof(DirectoryEntry), d->name_size);
+            seg->chats.insert_or_assign(chat, Range { d->min_id, d->max_id, (const Entry*)(base + d->entries), d->count });
+            at = padded(at + sizeof(DirectoryEntry) + d->name_size);
+        }
+        return seg;
+    }
+
+    // Writes the footer of a segment whose records are all in `index`, and reopens it sealed
+    std::shared_ptr<Segment> seal(Segment& seg, FlatMap<std::vector<Entry>>& index) {
+        PULSAR_TRACE_SCOPE("log seal");
+        index.for_each([](const std::string&, std::vector<Entry>& entries) {
+            std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.id < b.id; });
+        });
+        auto tail = footer(index, seg.end);
+        seg.file->write(seg.end, tail.data(), tail.size());
+        seg.file->sync();
+
+        seg.mapping.reset();
+        return openSealed(seg.seq, std::move(seg.file), seg.end + tail.size());
+    }
+
+    // Scans an unsealed segment, cutting it after the last intact record
+    std::shared_ptr<Segment> recover(uint64_t seq, std::unique_ptr<MappedFile> file, FlatMap<std::vector<Entry>>& index) {
+        size_t size = file->size();
+        auto mapping = file->map(size, true);
+
+        size_t end = 0;
+        while (auto r = validRecord(mapping->data(), size, end)) {
+            index[recordChat(mapping->data(), end)].push_back({ r->id, end });
+            end += r->size;
+        }
+        mapping.reset();
+        if (end != size) file->truncate(end);
+
+        auto seg = std::make_shared<Segment>();
+        seg->seq = seq;
+        seg->end = end;
+        seg->mapping = file->map(end);
+        seg->file = std::move(file);
+        return seg;
+    }
+
+    void startSegment() {
+        active = std::make_shared<Segment>();
+        active->seq = next_seq++;
+        active->file = std::make_unique<MappedFile>(segmentPath(active->seq));
+        active->mapping = active->file->map(0);
+        active_index.clear();
+    }
+
+    // Called by the one committing thread only
+    void commit(Batch& batch) {
+        PULSAR_TRACE_SCOPE("log commit");
+        if (batch.bytes.empty()) return;
+
+        if (active->end > 0 && active->end + batch.bytes.size() > segment_bytes) {
+            std::unique_lock lk(mtx);       // readers look at the active index and mapping, seal() changes both
+            sealed.push_back(seal(*active, active_index));
+            startSegment();
+            if (sealed.size() >= PULSAR_LOG_COMPACT_SEGMENTS) requestCompaction();
+        }
+
+        active->file->write(active->end, batch.bytes.data(), batch.bytes.size());
+        active->file->sync();
+
+        // readers see the batch only once it is in the file
+        auto mapping = active->file->map(active->end + batch.bytes.size());
+        std::unique_lock lk(mtx);
+        for (auto& [chat, entry] : batch.entries) active_index[chat.str()].push_back({ entry.id, active->end + entry.offset });
+        active->end += batch.bytes.size();
+        active->mapping = std::move(mapping);
+    }
+
+    void requestCompaction() {
+        {
+            std::lock_guard lk(compact_mtx);
+            compact_wanted = true;
+        }
+        compact_cv.notify_one();
+    }
+
+    void compactLoop() {
+        PULSAR_TRACE_THREAD("log compaction");
+        std::unique_lock lk(compact_mtx);
+        while (true) {
+            compact_cv.wait(lk, [&] { return compact_wanted || stopping; });
+            if (stopping) return;
+            compact_wanted = false;
+            lk.unlock();
+            try {
+                while (compact()) {}
+            } catch (const std::exception&) {
+                // the inputs stay as they are, the next seal tries again
+            }
+            lk.lock();
+        }
+    }
+
+    // Merges the smallest sealed segments into one. Returns false if there were too few of them.
+    bool compact() {
+        std::vector<std::shared_ptr<Segment>> inputs;
+        {
+            std::shared_lock lk(mtx);
+            inputs = sealed;
+        }
+
+        // Size-tiered: only segments of about the same size are merged, so a message is rewritten
+        // a logarithmic number of times instead of with every merge into one ever-growing segment
+        std::sort(inputs.begin(), inputs.end(), [](auto& a, auto& b) { return a->end < b->end; });
+        const size_t n = PULSAR_LOG_COMPACT_SEGMENTS;
+        size_t first = 0;
+        while (first + n <= inputs.size() && inputs[first + n - 1]->end > 2 * inputs[first]->end) first++;
+        if (first + n > inputs.size()) return false;
+        inputs = { inputs.begin() + first, inputs.begin() + first + n };
+
+        uint64_t seq;
+        {
+            std::unique_lock lk(mtx);
+            seq = next_seq++;
+        }
+        PULSAR_TRACE_SCOPE("log compact");
+        auto start = Metrics::Clock::now();
+
+        struct Source {
+            const char* base;
+            Entry entry;
+        };
+        FlatMap<std::vector<Source>> chats;
+        for (auto& seg : inputs) {
+            seg->chats.for_each([&](const std::string& chat, const Range& range) {
+                auto& list = chats[chat];
+                for (size_t i = 0; i < range.count; i++) list.push_back({ seg->mapping->data(), range.entries[i] });
+            });
+        }
+
+        auto tmp = segmentPath(seq, ".tmp");
+        auto file = std::make_unique<MappedFile>(tmp);
+
+        FlatMap<std::vector<Entry>> index;
+        std::string buffer;
+        size_t end = 0;
+        chats.for_each([&](const std::string& chat, std::vector<Source>& list) {
+            std::stable_sort(list.begin(), list.end(), [](const Source& a, const Source& b) { return a.entry.id < b.entry.id; });
+
+            std::vector<Entry> entries;
+            for (size_t i = 0; i < list.size(); i++) {
+                if (i > 0 && list[i].entry.id == list[i - 1].entry.id) continue;     // stored twice
+                auto r = (const Record*)(list[i].base + list[i].entry.offset);
+                entries.push_back({ r->id, end + buffer.size() });
+                buffer.append((const char*)r, r->size);
+                if (buffer.size() >= (1 << 20)) {
+                    file->write(end, buffer.data(), buffer.size());
+                    end += buffer.size();
+                    buffer.clear();
+                }
+            }
+            index.insert_or_assign(chat, std::move(entries));
+        });
+        file->write(end, buffer.data(), buffer.size());
+        end += buffer.size();
+
+        auto tail = footer(index, end);
+        file->write(end, tail.data(), tail.size());
+        file->sync();
+        file.reset();
+
+        std::filesystem::rename(tmp, segmentPath(seq));
+        auto output = openSealed(seq, std::make_unique<MappedFile>(segmentPath(seq)), end + tail.size());
+
+        {
+            std::unique_lock lk(mtx);
+            std::erase_if(sealed, [&](auto& seg) { return std::find(inputs.begin(), inputs.end(), seg) != inputs.end(); });
+            sealed.push_back(std::move(output));
+        }
+        for (auto& seg : inputs) {
+            std::error_code ec;     // still mapped by a reader on Windows: left for the next start, duplicates are dropped anyway
+            std::filesystem::remove(seg->file->getPath(), ec);
+        }
+
+        Metrics::Registry::global().histogram("pulsar_log_compaction_seconds", "Time to merge sealed history log segments").record(Metrics::Clock::now() - start);
+        return true;
+    }
+
+public:
+    /// Opens (or creates) the log in `directory`. Messages addressed to `username` are kept under their sender.
+    MessageLog(const std::filesystem::path& directory, const std::string& username, size_t segment_bytes = PULSAR_LOG_SEGMENT_BYTES)
+     : dir(directory), username(username), segment_bytes(segment_bytes) {
+        std::filesystem::create_directories(dir);
+
+        std::vector<uint64_t> seqs;
+        for (auto& file : std::filesystem::directory_iterator(dir)) {
+            auto name = file.path().filename().string();
+            if (file.path().extension() == ".tmp") {
+                std::filesystem::remove(file.path());       // compaction cut short, its inputs are still there
+                continue;
+            }
+            if (file.path().extension() != ".log" || name.size() != 20) continue;
+            seqs.push_back(std::stoull(name.substr(0, 16)));
+        }
+        std::sort(seqs.begin(), seqs.end());
+
+        for (auto seq : seqs) {
+            next_seq = seq + 1;
+            auto file = std::make_unique<MappedFile>(segmentPath(seq));
+            size_t size = file->size();
+            bool is_sealed;
+            {
+                auto mapping = file->map(size);
+                is_sealed = isSealed(mapping->data(), size);
+            }
+            if (is_sealed) {
+                sealed.push_back(openSealed(seq, std::move(file), size));
+                continue;
+            }
+
+            // only the newest segment can be unsealed, unless a seal was interrupted
+            if (active) sealed.push_back(seal(*active, active_index));
+            active_index.clear();
+            active = recover(seq, std::move(file), active_index);
+        }
+        if (!active) startSegment();
+
+        compactor = std::thread { &MessageLog::compactLoop, this };
+        if (sealed.size() >= PULSAR_LOG_COMPACT_SEGMENTS) requestCompaction();
+    }
+
+    ~MessageLog() {
+        {
+            std::lock_guard lk(compact_mtx);
+            stopping = true;
+        }
+        compact_cv.notify_one();
+        if (compactor.joinable()) compactor.join();
+
+        // sealed now, the next open reads its footer instead of scanning it
+        try {
+            std::unique_lock lk(mtx);
+            if (active && active->end > 0) sealed.push_back(seal(*active, active_index));
+        } catch (const std::exception&) {}
+    }
+
+    MessageLog(const MessageLog&) = delete;
+    MessageLog& operator=(const MessageLog&) = delete;
+
+    /// Returns once the messages are on disk. Concurrent callers share one write and one fsync.
+    void store_history(const std::vector<Message>& msgs) override {
+        std::unique_lock lk(commit_mtx);
+        auto batch = filling;
+        for (auto& msg : msgs) {
+            if (msg.get_id() == 0) continue;
+            auto& chat = chat_of(msg, username);
+            batch->entries.push_back({ Symbol(chat), { msg.get_id(), batch->bytes.size() } });
+            encode(batch->bytes, chat, msg);
+        }
+
+        while (!batch->done) {
+            if (committing) {
+                commit_cv.wait(lk);
+                continue;
+            }
+
+            // leader: write everything queued so far, including batches of callers still waiting
+            committing = true;
+            auto mine = std::exchange(filling, std::make_shared<Batch>());
+            lk.unlock();
+            try {
+                commit(*mine);
+            } catch (...) {
+                mine->error = std::current_exception();
+            }
+            lk.lock();
+            mine->done = true;
+            committing = false;
+            commit_cv.notify_all();
+        }
+        if (batch->error) std::rethrow_exception(batch->error);
+    }
+
+    std::vector<Message> history(const std::string& chat, size_t before = std::numeric_limits<size_t>::max(), size_t limit = 50) override {
+        PULSAR_TRACE_SCOPE("log history", chat);
+
+        struct Hit {
+            uint64_t id;
+            const char* base;
+            uint64_t offset;
+        };
+        std::vector<Hit> hits;
+        std::vector<std::shared_ptr<const FileMapping>> pinned;     // keeps what the hits point into mapped
+
+        {
+            std::shared_lock lk(mtx);
+            for (auto& seg : sealed) {
+                auto range = seg->chats.find(chat);
+                if (!range || range->count == 0 || range->min_id >= before) continue;
+
+                auto last = std::lower_bound(range->entries, range->entries + range->count, before,
+                                             [](const Entry& e, uint64_t id) { return e.id < id; });
+                auto first = last - std::min<size_t>(limit, last - range->entries);
+                for (auto e = first; e != last; e++) hits.push_back({ e->id, seg->mapping->data(), e->offset });
+                pinned.push_back(seg->mapping);
+            }
+
+            if (auto entries = active_index.find(chat)) {
+                for (auto& e : *entries) {
+                    if (e.id < before) hits.push_back({ e.id, active->mapping->data(), e.offset });
+                }
+                pinned.push_back(active->mapping);
+            }
+        }
+
+        std::sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) { return a.id > b.id; });
+        hits.erase(std::unique(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) { return a.id == b.id; }), hits.end());
+        if (hits.size() > limit) hits.resize(limit);
+
+        std::vector<Message> out;
+        out.reserve(hits.size());
+        for (auto i = hits.rbegin(); i != hits.rend(); i++) out.push_back(decode(i->base, i->offset));
+        return out;
+    }
+
+    /// Segment files, sealed and active
+    size_t segments() {
+        std::shared_lock lk(mtx);
+        return sealed.size() + 1;
+    }
+};
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <SFML/Network.hpp>
+#include <vector>
+#include <cstdint>
+
+#if defined(__linux__)
+#   include <sys/epoll.h>
+#   include <sys/eventfd.h>
+#   include <unistd.h>
+#   define PULSAR_POLLER_EPOLL
+#elif defined(_WIN32)
+#   include <winsock2.h>
+#else
+#   include <poll.h>
+#   include <unistd.h>
+#   include <fcntl.h>
+#endif
+
+// sf::Socket hides its descriptor, these expose it for the Poller
+class PollableSocket : public sf::TcpSocket {
+public:
+    using sf::TcpSocket::getNativeHandle;
+};
+
+class PollableListener : public sf::TcpListener {
+public:
+    using sf::TcpListener::getNativeHandle;
+};
+
+// Readiness notification for many non-blocking sockets from one thread.
+// epoll on Linux, poll()/WSAPoll() elsewhere. Level-triggered.
+// wake() may be called from any thread to interrupt wait().
+class Poller {
+public:
+    using Handle = sf::SocketHandle;
+
+    enum : uint32_t {
+        Read   = 1,
+        Write  = 2,
+        Hangup = 4
+    };
+
+    struct Event {
+        void* data;             // nullptr for wake()
+        uint32_t events;
+    };
+
+private:
+#ifdef PULSAR_POLLER_EPOLL
+    int epfd = -1;
+    int wake_fd = -1;
+    std::vector<epoll_event> ready;
+
+    static uint32_t toNative(uint32_t events) {
+        return ((events & Read) ? uint32_t(EPOLLIN) : 0u) | ((events & Write) ? uint32_t(EPOLLOUT) : 0u);
+    }
+#else
+  #ifdef _WIN32
+    using pollfd_t = WSAPOLLFD;
+  #else
+    using pollfd_t = pollfd;
+    int wake_fd[2] = { -1, -1 };
+  #endif
+    std::vector<pollfd_t> fds;
+    std::vector<void*> datas;
+
+    static short toNative(uint32_t events) {
+        return ((events & Read) ? POLLIN : 0) | ((events & Write) ? POLLOUT : 0);
+    }
+
+    size_t indexOf(Handle fd) const {
+        for (size_t i = 0; i < fds.size(); i++) if (fds[i].fd == fd) return i;
+        return fds.size();
+    }
+#endif
+
+public:
+    Poller() {
+#ifdef PULSAR_POLLER_EPOLL
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event ev { EPOLLIN, { .ptr = nullptr } };
+        epoll_ctl(epfd, EPOLL_CTL_ADD, wake_fd, &ev);
+#elif !defined(_WIN32)
+        if (pipe(wake_fd) == 0) {
+            fcntl(wake_fd[0], F_SETFL, O_NONBLOCK);
+            fcntl(wake_fd[1], F_SETFL, O_NONBLOCK);
+            fds.push_back({ wake_fd[0], POLLIN, 0 });
+            datas.push_back(nullptr);
+        }
+#endif
+    }
+
+    ~Poller() {
+#ifdef PULSAR_POLLER_EPOLL
+        close(wake_fd);
+        close(epfd);
+#elif !defined(_WIN32)
+        close(wake_fd[0]);
+        close(wake_fd[1]);
+#endif
+    }
+
+    Poller(const Poller&) = delete;
+    Poller& operator=(const Poller&) = delete;
+
+    bool add(Handle fd, uint32_t events, void* data) {
+#ifdef PULSAR_POLLER_EPOLL
+        epoll_event ev { toNative(events), { .ptr = data } };
+        return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == 0;
+#else
+        fds.push_back({ fd, toNative(events), 0 });
+        datas.push_back(data);
+        return true;
+#endif
+    }
+
+    bool modify(Handle fd, uint32_t events, void* data) {
+#ifdef PULSAR_POLLER_EPOLL
+        epoll_event ev { toNative(events), { .ptr = data } };
+        return epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev) == 0;
+#else
+        auto i = indexOf(fd);
+        if (i == fds.size()) return false;
+        fds[i].events = toNative(events);
+        datas[i] = data;
+        return true;
+#endif
+    }
+
+    void remove(Handle fd) {
+#ifdef PULSAR_POLLER_EPOLL
+        epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+#else
+        auto i = indexOf(fd);
+        if (i == fds.size()) return;
+        fds[i] = fds.back();
+        fds.pop_back();
+        datas[i] = datas.back();
+        datas.pop_back();
+#endif
+    }
+
+    void wake() {
+#ifdef PULSAR_POLLER_EPOLL
+        uint64_t one = 1;
+        (void)!::write(wake_fd, &one, sizeof(one));
+#elif !defined(_WIN32)
+        char c = 0;
+        (void)!::write(wake_fd[1], &c, 1);
+#endif
+    }
+
+    /// Waits up to timeout_ms (-1 - forever) and fills `out` with ready sockets.
+    /// On Windows wake() is not interruptible, the wait is capped at 10 ms instead.
+    void wait(std::vector<Event>& out, int timeout_ms) {
+        out.clear();
+
+#ifdef PULSAR_POLLER_EPOLL
+        if (ready.size() < 256) ready.resize(256);
+
+        int n = epoll_wait(epfd, ready.data(), (int)ready.size(), timeout_ms);
+        for (int i = 0; i < n; i++) {
+            auto& ev = ready[i];
+            if (!ev.data.ptr) {
+                uint64_t count;
+                (void)!::read(wake_fd, &count, sizeof(count));
+                out.push_back({ nullptr, Read });
+                continue;
+            }
+
+            uint32_t events = 0;
+            if (ev.events & EPOLLIN) events |= Read;
+            if (ev.events & EPOLLOUT) events |= Write;
+            if (ev.events & (EPOLLHUP | EPOLLERR)) events |= Hangup;
+            out.push_back({ ev.data.ptr, events });
+        }
+        if (n == (int)ready.size()) ready.resize(ready.size() * 2);
+#else
+  #ifdef _WIN32
+        if (timeout_ms < 0 || timeout_ms > 10) timeout_ms = 10;
+        int n = fds.empty() ? (Sleep(timeout_ms), 0) : WSAPoll(fds.data(), (ULONG)fds.size(), timeout_ms);
+  #else
+        int n = ::poll(fds.data(), fds.size(), timeout_ms);
+  #endif
+        for (size_t i = 0; n > 0 && i < fds.size(); i++) {
+            auto revents = fds[i].revents;
+            if (!revents) continue;
+            n--;
+
+            if (!datas[i]) {
+  #ifndef _WIN32
+                char buf[64];
+                while (::read(wake_fd[0], buf, sizeof(buf)) > 0) {}
+  #endif
+                out.push_back({ nullptr, Read });
+                continue;
+            }
+
+            uint32_t events = 0;
+            if (revents & POLLIN) events |= Read;
+            if (revents & POLLOUT) events |= Write;
+            if (revents & (POLLHUP | POLLERR)) events |= Hangup;
+            out.push_back({ datas[i], events });
+        }
+#endif
+    }
+};
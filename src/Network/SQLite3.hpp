@@ -9,6 +9,9 @@
 #include <vector>
 #include <functional>
 
+#include "../Other/Metrics.hpp"
+#include "../Other/Trace.hpp"
+
 class SQLite3Database {
 private:
     sqlite3* db_ = nullptr;
@@ -48,6 +51,9 @@ private:
     }
 
     void execute(std::string_view sql) {
+        static auto& latency = Metrics::Registry::global().histogram("pulsar_sqlite_seconds", "SQLite statement latency", Metrics::label("op", "execute"));
+        Metrics::Timer timer(latency);
+        PULSAR_TRACE_SCOPE("sqlite.execute", sql);
         char* errMsg = nullptr;
 
         if (sqlite3_exec(
@@ -65,6 +71,9 @@ private:
     }
 
     void query(std::string_view sql, const QueryCallback& cb) {
+        static auto& latency = Metrics::Registry::global().histogram("pulsar_sqlite_seconds", "SQLite statement latency", Metrics::label("op", "query"));
+        Metrics::Timer timer(latency);
+        PULSAR_TRACE_SCOPE("sqlite.query", sql);
         char* errMsg = nullptr;
 
         struct Context {
@@ -2,45 +2,19 @@
 
 #include <vector>
 #include <string>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <algorithm>
+#include <cstring>
 #include "Message.hpp"
+#include "Tokenizer.hpp"
 
-static Message parse_line(const std::string& line, const std::string& /*name*/) {
-    try {
-        return Message::from_payload(line);
-    } catch (...) {
-        return Message(0, "@unknown", ":unknown", line);
-    }
-}
-
-std::vector<std::string> split(const std::string& str, char sep = ' ') {
-    std::vector<std::string> result;
-    std::string current;
-    bool opened_quot = false;  // ' (single quot)
-    bool opened_quot2 = false; // " (double quot)
-
-    for (char c : str) {
-        if (c == sep && !opened_quot && !opened_quot2) {
-            if (!current.empty()) {
-                result.push_back(current);
-                current.clear();
-            }
-        } else if (c == '\'' && !opened_quot2) {
-            opened_quot = !opened_quot;
-        } else if (c == '\"' && !opened_quot) {
-            opened_quot2 = !opened_quot2;
-        } else {
-            current += c;
-        }
-    }
-
-    if (!current.empty()) {
-        result.push_back(current);
-    }
-
-    return result;
+inline std::vector<std::string> split(std::string str, char sep = ' ') {
+    return Tokenizer(str, sep).to_vector();
 }
 
-std::string join(const std::vector<std::string>& vec, char sep = ' ') {
+inline std::string join(const std::vector<std::string>& vec, char sep = ' ') {
     std::ostringstream oss;
     bool first = true;
     for (auto& s : vec) {
@@ -51,30 +25,83 @@ std::string join(const std::vector<std::string>& vec, char sep = ' ') {
     return oss.str();
 }
 
-class Chat {
+// Owns a raw !chat response and everything parsed out of it; freed all at once with the chat.
+// Messages only point into the buffer, so a history of any size takes a few allocations
+// instead of several per line.
+class ChatArena {
 private:
-    std::vector<Message> messages;
+    std::string raw;
+    std::pmr::monotonic_buffer_resource resource;
+    std::pmr::vector<MessageView> views { &resource };
+
 public:
-    Chat(const std::string& name, const std::vector<std::string>& messages_vec) {
-        for (auto& line : messages_vec) {
+    explicit ChatArena(std::string response)
+     : raw(std::move(response)), resource(max_lines(raw) * sizeof(MessageView)) {
+        views.reserve(max_lines(raw));
+
+        // Split on the separator alone: unlike Tokenizer, quotes in a message are just text
+        static const Symbol unknown_src { "@unknown" }, unknown_dst { ":unknown" };
+        for (std::string_view rest = raw; !rest.empty(); ) {
+            auto line = rest.substr(0, rest.find(PULSAR_SEP));
+            rest.remove_prefix(std::min(rest.size(), line.size() + 1));
             if (line.empty() || line == "\n") continue;
-            messages.push_back(parse_line(line, name));
+
+            MessageView view;
+            if (!Message::parse(line, view)) view = { 0, Datetime::now().toTime(), unknown_src, unknown_dst, line };
+            views.push_back(view);
         }
+        compact();
     }
 
-    #pragma CLANG "std::doctor"
-    std::stringstream to_stream() {
+    ChatArena(const ChatArena&) = delete;
+    ChatArena& operator=(const ChatArena&) = delete;
+
+    std::span<const MessageView> messages() const { return views; }
+
+private:
+    static size_t max_lines(const std::string& raw) {
+        return std::count(raw.begin(), raw.end(), PULSAR_SEP) + 1;
+    }
+
+    // Keeps only the texts: headers and padding are most of a payload, there is no need to hold on to them
+    void compact() {
+        char* out = raw.data();
+        for (auto& view : views) {
+            std::memmove(out, view.msg.data(), view.msg.size());
+            out += view.msg.size();
+        }
+        raw.resize(out - raw.data());
+        raw.shrink_to_fit();
+
+        const char* text = raw.data();
+        for (auto& view : views) {
+            view.msg = { text, view.msg.size() };
+            text += view.msg.size();
+        }
+    }
+};
+
+class Chat {
+private:
+    std::unique_ptr<ChatArena> arena;      // on the heap, so moving the chat keeps the views valid
+public:
+    Chat(const std::string& /*name*/, std::string response)
+     : arena(std::make_unique<ChatArena>(std::move(response))) {}
+
+    std::stringstream to_stream() const {
         std::stringstream ss;
-        for (auto i : messages) {
-            ss << i << std::endl;
+        for (auto& msg : getMessages()) {
+            ss << msg << std::endl;
         }
         return ss;
     }
 
-    Message getByID(size_t id) {
-        for (auto& msg : messages) {
-            if (msg.get_id() == id) return msg;
+    std::span<const MessageView> getMessages() const { return arena->messages(); }
+
+    Message getByID(size_t id) const {
+        for (auto& msg : getMessages()) {
+            if (msg.id == id) return msg.to_message();
         }
         return PULSAR_NO_MESSAGE;
     }
-};
\ No newline at end of file
+};
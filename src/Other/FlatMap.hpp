@@ -0,0 +1,122 @@
+#pragma once
+
+#include "../lib/hash.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Open-addressing hash map from strings, linear probing in one flat array.
+// Meant for small lookup tables read far more often than written: a hit is one hash and
+// usually one slot, without the per-node allocations of std::unordered_map.
+template <typename _Value>
+class FlatMap {
+private:
+    struct Slot {
+        std::string key;
+        _Value value {};
+        uint32_t hash = 0;
+        bool used = false;
+    };
+
+    std::vector<Slot> slots;
+    size_t count = 0;
+
+    size_t mask() const { return slots.size() - 1; }
+
+    // Slot holding `key`, or the free slot where it would go
+    size_t probe(std::string_view key, uint32_t h) const {
+        size_t i = h & mask();
+        while (slots[i].used && (slots[i].hash != h || slots[i].key != key)) i = (i + 1) & mask();
+        return i;
+    }
+
+    void grow() {
+        std::vector<Slot> old(slots.empty() ? 16 : slots.size() * 2);
+        old.swap(slots);
+        for (auto& s : old) {
+            if (!s.used) continue;
+            slots[probe(s.key, s.hash)] = std::move(s);
+        }
+    }
+
+public:
+    size_t size() const { return count; }
+
+    bool empty() const { return count == 0; }
+
+    void clear() {
+        slots.clear();
+        count = 0;
+    }
+
+    /// nullptr if there is no such key. Valid until the next insertion
+    const _Value* find(std::string_view key) const {
+        if (count == 0) return nullptr;
+        auto& slot = slots[probe(key, fnv1a(key))];
+        return slot.used ? &slot.value : nullptr;
+    }
+
+    _Value* find(std::string_view key) {
+        return const_cast<_Value*>(static_cast<const FlatMap&>(*this).find(key));
+    }
+
+    bool contains(std::string_view key) const { return find(key) != nullptr; }
+
+    /// Value of `key`, default-constructed first if there is none. Valid until the next insertion
+    _Value& operator[](std::string_view key) {
+        if (auto value = find(key)) return *value;
+        insert_or_assign(key, _Value {});
+        return *find(key);
+    }
+
+    void insert_or_assign(std::string_view key, _Value value) {
+        if ((count + 1) * 2 > slots.size()) grow();     // load factor stays under 1/2
+
+        uint32_t h = fnv1a(key);
+        auto& slot = slots[probe(key, h)];
+        if (!slot.used) {
+            slot.key = key;
+            slot.hash = h;
+            slot.used = true;
+            count++;
+        }
+        slot.value = std::move(value);
+    }
+
+    /// fn(key, value) for every entry, in no particular order
+    template <typename _Fn>
+    void for_each(_Fn&& fn) const {
+        for (auto& s : slots) {
+            if (s.used) fn(s.key, s.value);
+        }
+    }
+
+    template <typename _Fn>
+    void for_each(_Fn&& fn) {
+        for (auto& s : slots) {
+            if (s.used) fn(std::as_const(s.key), s.value);
+        }
+    }
+
+    bool erase(std::string_view key) {
+        if (count == 0) return false;
+
+        size_t i = probe(key, fnv1a(key));
+        if (!slots[i].used) return false;
+
+        // Backward shift: pull later entries of the probe run into the hole, so lookups never need tombstones
+        size_t hole = i;
+        for (size_t j = (i + 1) & mask(); slots[j].used; j = (j + 1) & mask()) {
+            size_t home = slots[j].hash & mask();
+            bool between = hole <= j ? (hole < home && home <= j) : (hole < home || home <= j);
+            if (between) continue;
+            slots[hole] = std::move(slots[j]);
+            hole = j;
+        }
+        slots[hole] = Slot {};
+        count--;
+        return true;
+    }
+};
@@ -2,7 +2,12 @@
 
 #include "../defines"
 #include "Datetime.hpp"
+#include "Symbol.hpp"
 #include <string>
+#include <string_view>
+#include <charconv>
+#include <stdexcept>
+#include <algorithm>
 #include <ostream>
 #include <sstream>
 #include <iomanip>
@@ -36,27 +41,45 @@ inline void remove_spaces(std::string& s) {
     );
 }
 
+class Message;
+
+// Message parsed in place by Message::parse(): the text points into the buffer it was parsed from
+struct MessageView {
+    size_t id = 0;
+    time_t time = 0;
+    Symbol src;
+    Symbol dst;
+    std::string_view msg;
+
+    Message to_message() const;
+};
+
 class Message {
 private:
     size_t id;
     Datetime time;
-    std::string src;
-    std::string dst;
+    Symbol src;             // names are interned, a message holds only their indices
+    Symbol dst;
     std::string msg;
 public:
-    Message() : id(0), time(0), src(""), dst(""), msg("") {}
+    Message() : id(0), time(0) {}
+
+    Message(size_t id, std::string_view src, std::string_view dst, std::string msg)
+     : id(id), time(Datetime::now()), src(src), dst(dst), msg(std::move(msg)) {}
 
-    Message(size_t id, const std::string& src, const std::string& dst, const std::string& msg)
-     : id(id), src(src), dst(dst), msg(msg), time(Datetime::now()) {}
+    Message(size_t id, time_t time, std::string_view src, std::string_view dst, std::string msg)
+     : id(id), time(time), src(src), dst(dst), msg(std::move(msg)) {}
 
-     Message(size_t id, time_t time, const std::string& src, const std::string& dst, const std::string& msg)
-     : id(id), src(src), dst(dst), msg(msg), time(time) {}
+    Message(size_t id, time_t time, Symbol src, Symbol dst, std::string msg)
+     : id(id), time(time), src(src), dst(dst), msg(std::move(msg)) {}
 
     inline size_t get_id() const { return id; }
     inline Datetime get_time() const { return time; }
-    inline std::string get_src() const { return src; }
-    inline std::string get_dst() const { return dst; }
-    inline std::string get_msg() const { return msg; }
+    inline const std::string& get_src() const { return src.str(); }
+    inline const std::string& get_dst() const { return dst.str(); }
+    inline const std::string& get_msg() const { return msg; }
+    inline Symbol get_src_symbol() const { return src; }
+    inline Symbol get_dst_symbol() const { return dst; }
 
     std::string to_payload() const {
         std::ostringstream oss;
@@ -74,25 +97,77 @@ public:
         return message.to_payload();
     }
 
-    static Message from_payload(const std::string& payload) {
+    static Message from_payload(std::string_view payload) {
         size_t id;
         time_t time;
-        std::string src, dst, msg;
-        
-        id = std::stoul(payload.substr(0, PULSAR_ID_SIZE));
-        time = std::stol(payload.substr(PULSAR_ID_SIZE, PULSAR_TIME_SIZE));
-        src = payload.substr(PULSAR_ID_SIZE + PULSAR_TIME_SIZE, PULSAR_SRC_SIZE);
-        dst = payload.substr(PULSAR_ID_SIZE + PULSAR_TIME_SIZE + PULSAR_SRC_SIZE, PULSAR_DST_SIZE);
-        msg = payload.substr(PULSAR_ID_SIZE + PULSAR_TIME_SIZE + PULSAR_SRC_SIZE + PULSAR_DST_SIZE);
-
-        remove_spaces(src);
-        remove_spaces(dst);
-        
-        return { id, time, src, dst, msg };
+
+        id = parse_field<size_t>(payload.substr(0, PULSAR_ID_SIZE));
+        time = parse_field<time_t>(payload.substr(PULSAR_ID_SIZE, PULSAR_TIME_SIZE));
+        auto src = name_field(payload.substr(PULSAR_ID_SIZE + PULSAR_TIME_SIZE, PULSAR_SRC_SIZE));
+        auto dst = name_field(payload.substr(PULSAR_ID_SIZE + PULSAR_TIME_SIZE + PULSAR_SRC_SIZE, PULSAR_DST_SIZE));
+        std::string msg { payload.substr(PULSAR_ID_SIZE + PULSAR_TIME_SIZE + PULSAR_SRC_SIZE + PULSAR_DST_SIZE) };
+
+        return { id, time, src, dst, std::move(msg) };
+    }
+
+    /// from_payload() that neither throws on a malformed payload (returns false) nor copies the text
+    static bool parse(std::string_view payload, MessageView& out) {
+        constexpr size_t header = PULSAR_ID_SIZE + PULSAR_TIME_SIZE + PULSAR_SRC_SIZE + PULSAR_DST_SIZE;
+        if (payload.size() < header) return false;
+        if (scan_field(payload.substr(0, PULSAR_ID_SIZE), out.id) != std::errc {}) return false;
+        if (scan_field(payload.substr(PULSAR_ID_SIZE, PULSAR_TIME_SIZE), out.time) != std::errc {}) return false;
+
+        out.src = name_field(payload.substr(PULSAR_ID_SIZE + PULSAR_TIME_SIZE, PULSAR_SRC_SIZE));
+        out.dst = name_field(payload.substr(PULSAR_ID_SIZE + PULSAR_TIME_SIZE + PULSAR_SRC_SIZE, PULSAR_DST_SIZE));
+        out.msg = payload.substr(header);
+        return true;
+    }
+
+private:
+    // Padded name field without the whitespace, as remove_spaces() leaves it; copies only if there is space inside the name
+    static Symbol name_field(std::string_view field) {
+        auto space = [](char c) { return c == ' ' || (c >= '\t' && c <= '\r'); };     // std::isspace() in the "C" locale
+        auto first = std::find_if_not(field.begin(), field.end(), space);
+        auto last = std::find_if_not(field.rbegin(), std::make_reverse_iterator(first), space).base();
+        std::string_view name(first, last);
+        if (std::none_of(name.begin(), name.end(), space)) return Symbol(name);
+
+        std::string copy(name);
+        remove_spaces(copy);
+        return Symbol(copy);
+    }
+
+    // Leading spaces are skipped, std::errc::invalid_argument if there are no digits
+    template <typename _Int>
+    static std::errc scan_field(std::string_view field, _Int& value) {
+        size_t i = 0;
+        while (i < field.size() && std::isspace((unsigned char)field[i])) i++;
+
+        value = {};
+        return std::from_chars(field.data() + i, field.data() + field.size(), value).ec;
+    }
+
+    // Same contract as std::stoul/std::stol on the fixed-width numeric fields
+    template <typename _Int>
+    static _Int parse_field(std::string_view field) {
+        _Int value;
+        auto ec = scan_field(field, value);
+        if (ec == std::errc::invalid_argument) throw std::invalid_argument("Message: invalid numeric field");
+        if (ec == std::errc::result_out_of_range) throw std::out_of_range("Message: numeric field out of range");
+        return value;
     }
 };
 
 inline std::ostream& operator<<(std::ostream& os, const Message& m) {
     os << "<" << m.get_time().toFormattedString() << "> [id:" << m.get_id() << "] (от " << m.get_src() << " в " << m.get_dst() << "): " << m.get_msg();
     return os;
-};
\ No newline at end of file
+};
+
+inline Message MessageView::to_message() const {
+    return { id, time, src, dst, std::string(msg) };
+}
+
+inline std::ostream& operator<<(std::ostream& os, const MessageView& m) {
+    os << "<" << Datetime(m.time).toFormattedString() << "> [id:" << m.id << "] (от " << m.src << " в " << m.dst << "): " << m.msg;
+    return os;
+}
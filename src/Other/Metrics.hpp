@@ -0,0 +1,322 @@
+#pragma once
+
+#include "../defines"
+#include <algorithm>
+#include <atomic>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// Process-wide counters, gauges and latency histograms.
+// Hot-path updates are relaxed atomic adds on a per-thread shard, readers sum the shards.
+// Metrics live as long as the process, so references returned by the registry may be cached.
+namespace Metrics {
+    using Clock = std::chrono::steady_clock;
+
+    inline constexpr size_t SHARDS = 8;
+
+    // Threads take shards round-robin, up to SHARDS threads never share a cache line
+    inline size_t shard() {
+        static std::atomic<size_t> next = 0;
+        thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        return index;
+    }
+
+    class Counter {
+    private:
+        struct alignas(64) Cell {
+            std::atomic<uint64_t> value = 0;
+        };
+        std::array<Cell, SHARDS> cells;
+
+    public:
+        void inc(uint64_t n = 1) { cells[shard()].value.fetch_add(n, std::memory_order_relaxed); }
+
+        uint64_t value() const {
+            uint64_t sum = 0;
+            for (auto& c : cells) sum += c.value.load(std::memory_order_relaxed);
+            return sum;
+        }
+    };
+
+    /// Current level of something (queue depth), shared by all instances that add to it
+    class Gauge {
+    private:
+        std::atomic<int64_t> level = 0;
+
+    public:
+        void add(int64_t n) { level.fetch_add(n, std::memory_order_relaxed); }
+        void sub(int64_t n) { level.fetch_sub(n, std::memory_order_relaxed); }
+        void set(int64_t n) { level.store(n, std::memory_order_relaxed); }
+
+        int64_t value() const { return level.load(std::memory_order_relaxed); }
+    };
+
+    /// Log-linear histogram of nanoseconds, HDR style: every power of two is split into
+    /// 8 linear buckets, so any value is within 12.5% of its bucket bounds. Covers up to ~68 s.
+    class Histogram {
+    public:
+        static constexpr unsigned SUB_BITS = 3;
+        static constexpr uint64_t SUB = 1 << SUB_BITS;
+        static constexpr unsigned MAX_EXP = 36;
+        static constexpr size_t BUCKETS = (MAX_EXP - SUB_BITS + 1) * SUB + SUB;
+
+        static size_t indexOf(uint64_t ns) {
+            if (ns < SUB) return ns;
+            unsigned e = std::bit_width(ns) - 1;
+            size_t i = (e - SUB_BITS + 1) * SUB + ((ns >> (e - SUB_BITS)) & (SUB - 1));
+            return std::min(i, BUCKETS - 1);
+        }
+
+        static uint64_t lowerBound(size_t i) {
+            if (i < SUB) return i;
+            unsigned e = i / SUB + SUB_BITS - 1;
+            return (SUB + i % SUB) << (e - SUB_BITS);
+        }
+
+        struct Snapshot {
+            std::array<uint64_t, BUCKETS> buckets {};
+            uint64_t count = 0;
+            uint64_t sum = 0;
+            uint64_t max = 0;
+
+            /// Upper bound of the bucket holding quantile q, in nanoseconds
+            uint64_t quantile(double q) const {
+                if (count == 0) return 0;
+                uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(q * count)), seen = 0;
+                for (size_t i = 0; i < BUCKETS; i++) {
+                    seen += buckets[i];
+                    if (seen >= rank) return std::min(max, i + 1 < BUCKETS ? lowerBound(i + 1) : max);
+                }
+                return max;
+            }
+        };
+
+    private:
+        struct alignas(64) Shard {
+            std::array<std::atomic<uint64_t>, BUCKETS> buckets {};
+            std::atomic<uint64_t> count = 0;
+            std::atomic<uint64_t> sum = 0;
+            std::atomic<uint64_t> max = 0;
+        };
+        std::unique_ptr<Shard[]> shards = std::make_unique<Shard[]>(SHARDS);
+
+    public:
+        void record(uint64_t ns) {
+            auto& s = shards[shard()];
+            s.buckets[indexOf(ns)].fetch_add(1, std::memory_order_relaxed);
+            s.count.fetch_add(1, std::memory_order_relaxed);
+            s.sum.fetch_add(ns, std::memory_order_relaxed);
+
+            auto prev = s.max.load(std::memory_order_relaxed);
+            while (ns > prev && !s.max.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {}
+        }
+
+        void record(Clock::duration d) {
+            record((uint64_t)std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()));
+        }
+
+        Snapshot snapshot() const {
+            Snapshot res;
+            for (size_t k = 0; k < SHARDS; k++) {
+                auto& s = shards[k];
+                for (size_t i = 0; i < BUCKETS; i++) res.buckets[i] += s.buckets[i].load(std::memory_order_relaxed);
+                res.count += s.count.load(std::memory_order_relaxed);
+                res.sum += s.sum.load(std::memory_order_relaxed);
+                res.max = std::max(res.max, s.max.load(std::memory_order_relaxed));
+            }
+            return res;
+        }
+    };
+
+    /// Records the lifetime of the scope into a histogram
+    class Timer {
+    private:
+        Histogram& histogram;
+        Clock::time_point start = Clock::now();
+    public:
+        explicit Timer(Histogram& histogram) : histogram(histogram) {}
+        ~Timer() { histogram.record(Clock::now() - start); }
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+    };
+
+    /// `key="value"` with the value escaped for the Prometheus text format
+    inline std::string label(const std::string& key, const std::string& value) {
+        std::string res = key + "=\"";
+        for (auto c : value) {
+            if (c == '\\' || c == '"') res.push_back('\\');
+            if (c == '\n') {
+                res += "\\n";
+                continue;
+            }
+            res.push_back(c);
+        }
+        return res + "\"";
+    }
+
+    class Registry {
+    private:
+        template <typename _Metric>
+        struct Family {
+            std::string help;
+            std::map<std::string, std::unique_ptr<_Metric>> series;     // labels -> metric
+        };
+
+        std::mutex mtx;
+        std::map<std::string, Family<Counter>> counters;
+        std::map<std::string, Family<Gauge>> gauges;
+        std::map<std::string, Family<Histogram>> histograms;
+
+        std::thread dump_thr;
+        std::mutex dump_mtx;
+        std::condition_variable dump_cv;
+        bool dump_stop = false;
+
+        template <typename _Metric>
+        _Metric& get(std::map<std::string, Family<_Metric>>& families, const std::string& name, const std::string& help, const std::string& labels) {
+            std::lock_guard lk(mtx);
+            auto& family = families[name];
+            if (family.help.empty()) family.help = help;
+            auto& metric = family.series[labels];
+            if (!metric) metric = std::make_unique<_Metric>();
+            return *metric;
+        }
+
+        static std::string series(const std::string& name, const std::string& labels, const std::string& extra = "") {
+            std::string all = labels;
+            if (!extra.empty()) all += (all.empty() ? "" : ",") + extra;
+            return all.empty() ? name : name + "{" + all + "}";
+        }
+
+        // Bucket bounds reported to Prometheus, the fine buckets are merged into these
+        static constexpr double EXPORT_BOUNDS[] = { 1e-5, 5e-5, 1e-4, 5e-4, 1e-3, 5e-3, 1e-2, 5e-2, 0.1, 0.5, 1, 5, 10 };
+
+    public:
+        Registry() = default;
+
+        ~Registry() { stopDump(); }
+
+        Registry(const Registry&) = delete;
+        Registry& operator=(const Registry&) = delete;
+
+        static Registry& global() {
+            static Registry registry;
+            return registry;
+        }
+
+        /// @param labels already formatted, see label()
+        Counter& counter(const std::string& name, const std::string& help, const std::string& labels = "") {
+            return get(counters, name, help, labels);
+        }
+
+        Gauge& gauge(const std::string& name, const std::string& help, const std::string& labels = "") {
+            return get(gauges, name, help, labels);
+        }
+
+        /// Exported in seconds
+        Histogram& histogram(const std::string& name, const std::string& help, const std::string& labels = "") {
+            return get(histograms, name, help, labels);
+        }
+
+        /// Prometheus text exposition format
+        void prometheus(std::ostream& os) {
+            std::lock_guard lk(mtx);
+
+            for (auto& [name, family] : counters) {
+                os << "# HELP " << name << ' ' << family.help << "\n# TYPE " << name << " counter\n";
+                for (auto& [labels, c] : family.series) os << series(name, labels) << ' ' << c->value() << '\n';
+            }
+            for (auto& [name, family] : gauges) {
+                os << "# HELP " << name << ' ' << family.help << "\n# TYPE " << name << " gauge\n";
+                for (auto& [labels, g] : family.series) os << series(name, labels) << ' ' << g->value() << '\n';
+            }
+            for (auto& [name, family] : histograms) {
+                os << "# HELP " << name << ' ' << family.help << "\n# TYPE " << name << " histogram\n";
+                for (auto& [labels, h] : family.series) {
+                    auto snap = h->snapshot();
+
+                    uint64_t cumulative = 0;
+                    size_t i = 0;
+                    for (double bound : EXPORT_BOUNDS) {
+                        // a fine bucket counts towards `le` once all of it is below the bound
+                        while (i < Histogram::BUCKETS && Histogram::lowerBound(i + 1) <= bound * 1e9) cumulative += snap.buckets[i++];
+                        std::ostringstream le;
+                        le << bound;
+                        os << series(name + "_bucket", labels, label("le", le.str())) << ' ' << cumulative << '\n';
+                    }
+                    os << series(name + "_bucket", labels, "le=\"+Inf\"") << ' ' << snap.count << '\n';
+                    os << series(name + "_sum", labels) << ' ' << snap.sum / 1e9 << '\n';
+                    os << series(name + "_count", labels) << ' ' << snap.count << '\n';
+                }
+            }
+        }
+
+        /// Human-readable table for the !stats command
+        void summary(std::ostream& os) {
+            std::lock_guard lk(mtx);
+
+            for (auto& [name, family] : counters) {
+                for (auto& [labels, c] : family.series) os << "  " << std::setw(52) << std::left << series(name, labels) << c->value() << '\n';
+            }
+            for (auto& [name, family] : gauges) {
+                for (auto& [labels, g] : family.series) os << "  " << std::setw(52) << std::left << series(name, labels) << g->value() << '\n';
+            }
+
+            auto ms = [](uint64_t ns) { return ns / 1e6; };
+            for (auto& [name, family] : histograms) {
+                for (auto& [labels, h] : family.series) {
+                    auto snap = h->snapshot();
+                    if (snap.count == 0) continue;
+                    os << "  " << std::setw(52) << std::left << series(name, labels) << snap.count << " шт., мс:"
+                       << std::fixed << std::setprecision(3)
+                       << " p50 " << ms(snap.quantile(0.5)) << " p90 " << ms(snap.quantile(0.9))
+                       << " p99 " << ms(snap.quantile(0.99)) << " max " << ms(snap.max) << '\n';
+                    os.unsetf(std::ios::fixed);
+                }
+            }
+        }
+
+        /// Rewrites `path` with prometheus() output every `interval` until stopDump().
+        /// The file is replaced atomically, so a node_exporter textfile collector never reads it half-written.
+        void startDump(const std::string& path, std::chrono::milliseconds interval) {
+            stopDump();
+            dump_stop = false;
+            dump_thr = std::thread { [this, path, interval] {
+                std::unique_lock lk(dump_mtx);
+                do {
+                    {
+                        std::ofstream out(path + ".tmp", std::ios::trunc);
+                        prometheus(out);
+                    }
+                    std::error_code ec;
+                    std::filesystem::rename(path + ".tmp", path, ec);
+                } while (!dump_cv.wait_for(lk, interval, [this] { return dump_stop; }));
+            } };
+        }
+
+        void stopDump() {
+            if (!dump_thr.joinable()) return;
+            {
+                std::lock_guard lk(dump_mtx);
+                dump_stop = true;
+            }
+            dump_cv.notify_all();
+            dump_thr.join();
+        }
+    };
+}
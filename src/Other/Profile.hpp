@@ -4,6 +4,7 @@
 #include "../defines"
 #include <sstream>
 #include <vector>
+#include <stdexcept>
 #include "Datetime.hpp"
 
 class Profile {
@@ -59,6 +60,8 @@ public:
             parts.push_back(part);
         }
 
+        if (parts.size() < 4) throw std::invalid_argument("Profile: invalid payload");
+
         return Profile(parts[0], parts[1], parts[2], Datetime::fromString(parts[3]));
     }
 };
\ No newline at end of file
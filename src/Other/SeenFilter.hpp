@@ -0,0 +1,79 @@
+#pragma once
+
+#include "../defines"
+#include "FlatMap.hpp"
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <string_view>
+
+// Message ids already seen, per chat: the newest id and a bitmap of the PULSAR_SEEN_WINDOW ids below it,
+// so late and reordered ids are told apart from repeated ones. Ids older than the window count as seen.
+// A check is O(1) and a chat costs the same PULSAR_SEEN_WINDOW / 8 bytes however long its history is.
+class SeenFilter {
+private:
+    static_assert(PULSAR_SEEN_WINDOW % 64 == 0, "PULSAR_SEEN_WINDOW must be a multiple of 64");
+    static constexpr size_t words = PULSAR_SEEN_WINDOW / 64;
+
+    struct Window {
+        size_t newest = 0;
+        uint64_t bits[words] {};        // bit id % PULSAR_SEEN_WINDOW for ids in (newest - window, newest]
+
+        bool test(size_t id) const { return bits[id / 64 % words] >> (id % 64) & 1; }
+        void set(size_t id) { bits[id / 64 % words] |= uint64_t(1) << (id % 64); }
+        void reset(size_t id) { bits[id / 64 % words] &= ~(uint64_t(1) << (id % 64)); }
+
+        // Moves the window up to `id`: the ids skipped over are not seen yet
+        void advance(size_t id) {
+            if (id - newest >= PULSAR_SEEN_WINDOW) std::memset(bits, 0, sizeof(bits));
+            else {
+                for (size_t skipped = newest + 1; skipped < id; skipped++) reset(skipped);
+            }
+            newest = id;
+            set(id);
+        }
+    };
+
+    FlatMap<Window> chats;
+    std::map<std::string, size_t> saved;        // restore()d marks
+
+public:
+    /// Marks `id` of `chat` as seen.
+    /// @return false if it was seen before (or is older than the window), true for id 0 which is not a real id
+    bool note(std::string_view chat, size_t id) {
+        if (chat.empty() || id == 0) return true;
+        auto& w = chats[chat];
+        if (id > w.newest) {
+            w.advance(id);
+            return true;
+        }
+        if (w.newest - id >= PULSAR_SEEN_WINDOW || w.test(id)) return false;
+        w.set(id);
+        return true;
+    }
+
+    /// Newest id seen in `chat`, 0 if none
+    size_t newest(std::string_view chat) const {
+        auto w = chats.find(chat);
+        return w ? w->newest : 0;
+    }
+
+    /// Newest id of every chat, as Database::save_last_seen() keeps them: the one noted since
+    /// construction, or the restored mark of a chat nothing was noted in
+    std::map<std::string, size_t> marks() const {
+        auto out = saved;
+        chats.for_each([&](const std::string& chat, const Window& w) { out[chat] = w.newest; });
+        return out;
+    }
+
+    /// Takes the marks saved by an earlier session. They only carry over to marks(), which tells a resume
+    /// where to fetch from; no id is dropped because of them, as the server may have started its ids over since.
+    void restore(const std::map<std::string, size_t>& marks) {
+        for (auto& [chat, id] : marks) {
+            if (id != 0) saved[chat] = id;
+        }
+    }
+
+    size_t size() const { return chats.size(); }
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "Metrics.hpp"
+#include "Trace.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs independent stages concurrently, each one as soon as the stages it depends on have finished.
+// A stage that fails (returns false or throws) skips everything depending on it.
+// Stage durations go to the pulsar_stage_seconds{graph, stage} histogram and to the trace.
+class StageGraph {
+public:
+    enum State {
+        Waiting,
+        Done,
+        Failed,
+        Skipped
+    };
+
+    struct Stage {
+        std::string name;
+        std::vector<size_t> deps;
+        std::function<bool()> run;
+
+        State state = Waiting;
+        Metrics::Clock::duration start {}, duration {};     // start is relative to run()
+    };
+
+private:
+    std::string graph;
+    std::vector<Stage> stages;
+    std::map<std::string, size_t> index;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+
+public:
+    explicit StageGraph(std::string graph) : graph(std::move(graph)) {}
+
+    /// Dependencies must be added first, so the graph has no cycles by construction
+    void add(const std::string& name, const std::vector<std::string>& deps, std::function<bool()> run) {
+        if (index.contains(name)) throw std::invalid_argument("stage \"" + name + "\" added twice");
+
+        Stage stage { name, {}, std::move(run) };
+        for (auto& dep : deps) {
+            auto i = index.find(dep);
+            if (i == index.end()) throw std::invalid_argument("stage \"" + name + "\" depends on unknown \"" + dep + "\"");
+            stage.deps.push_back(i->second);
+        }
+
+        index[name] = stages.size();
+        stages.push_back(std::move(stage));
+    }
+
+    /// Blocks until every stage finished or was skipped. Returns true if all of them succeeded.
+    bool run() {
+        auto origin = Metrics::Clock::now();
+
+        std::vector<std::thread> threads;
+        threads.reserve(stages.size());
+        for (size_t i = 0; i < stages.size(); i++) {
+            threads.emplace_back([this, i, origin] {
+                auto& stage = stages[i];
+                PULSAR_TRACE_THREAD(stage.name.c_str());
+
+                bool runnable = true;
+                {
+                    std::unique_lock lk(mtx);
+                    cv.wait(lk, [&] {
+                        for (auto d : stage.deps) if (stages[d].state == Waiting) return false;
+                        return true;
+                    });
+                    for (auto d : stage.deps) runnable = runnable && stages[d].state == Done;
+                }
+
+                State state = Skipped;
+                auto start = Metrics::Clock::now();
+                if (runnable) {
+                    PULSAR_TRACE_SCOPE("stage", stage.name);
+                    try {
+                        state = stage.run() ? Done : Failed;
+                    } catch (const std::exception& e) {
+                        std::cout << "Этап \"" << stage.name << "\" завершился с ошибкой: " << e.what() << std::endl;
+                        state = Failed;
+                    }
+                }
+                auto end = Metrics::Clock::now();
+
+                if (runnable) {
+                    Metrics::Registry::global().histogram("pulsar_stage_seconds", "Duration of concurrent startup stages",
+                        Metrics::label("graph", graph) + "," + Metrics::label("stage", stage.name)).record(end - start);
+                }
+
+                {
+                    std::lock_guard lk(mtx);
+                    stage.start = start - origin;
+                    stage.duration = end - start;
+                    stage.state = state;
+                }
+                cv.notify_all();
+            });
+        }
+        for (auto& t : threads) t.join();
+
+        for (auto& stage : stages) if (stage.state != Done) return false;
+        return true;
+    }
+
+    const Stage& operator[](const std::string& name) const { return stages[index.at(name)]; }
+
+    const std::vector<Stage>& getStages() const { return stages; }
+
+    /// Timeline of the last run(): when every stage started and how long it took, in ms
+    void report(std::ostream& os) const {
+        auto ms = [](Metrics::Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+        const char* states[] = { "ожидание", "готово", "ошибка", "пропущено" };
+
+        for (auto& stage : stages) {
+            os << "  " << std::setw(12) << std::left << stage.name
+               << std::fixed << std::setprecision(1) << std::setw(10) << std::right << ms(stage.start)
+               << std::setw(10) << ms(stage.duration) << "  " << states[stage.state] << '\n';
+        }
+        os.unsetf(std::ios::fixed);
+    }
+};
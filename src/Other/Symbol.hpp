@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../defines"
+#include "FlatMap.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Interned name: a 32-bit index into a process-wide pool of strings that are never freed.
+// For usernames and chat names, of which there are a few hundred: every Message refers to the
+// pooled copy instead of owning one, and comparing two symbols compares two integers.
+class Symbol {
+private:
+    // Append-only: strings live in fixed chunks that never move, so str() reads without a lock
+    class Pool {
+    private:
+        static constexpr uint32_t chunk_size = 1024;
+
+        std::atomic<std::string*> chunks[PULSAR_SYMBOL_CHUNKS] {};
+        uint32_t count = 1;                 // index 0 is the empty string
+        FlatMap<uint32_t> index;
+        std::shared_mutex mtx;
+
+    public:
+        Pool() { chunks[0].store(new std::string[chunk_size], std::memory_order_release); }
+
+        ~Pool() {
+            for (auto& chunk : chunks) delete[] chunk.load(std::memory_order_relaxed);
+        }
+
+        uint32_t intern(std::string_view name) {
+            if (name.empty()) return 0;
+            {
+                std::shared_lock lk(mtx);
+                if (auto i = index.find(name)) return *i;
+            }
+
+            std::unique_lock lk(mtx);
+            if (auto i = index.find(name)) return *i;
+            if (count == chunk_size * PULSAR_SYMBOL_CHUNKS) throw std::length_error("Symbol: too many distinct names");
+
+            uint32_t i = count;
+            auto* chunk = chunks[i / chunk_size].load(std::memory_order_relaxed);
+            if (!chunk) {
+                chunk = new std::string[chunk_size];
+                chunks[i / chunk_size].store(chunk, std::memory_order_release);
+            }
+            chunk[i % chunk_size] = name;
+            index.insert_or_assign(name, i);
+            count++;
+            return i;
+        }
+
+        const std::string& str(uint32_t i) const {
+            return chunks[i / chunk_size].load(std::memory_order_acquire)[i % chunk_size];
+        }
+
+        size_t size() {
+            std::shared_lock lk(mtx);
+            return count;
+        }
+    };
+
+    static Pool& pool() {
+        static Pool instance;
+        return instance;
+    }
+
+    uint32_t i = 0;
+
+public:
+    Symbol() = default;
+
+    explicit Symbol(std::string_view name) : i(pool().intern(name)) {}
+
+    const std::string& str() const { return pool().str(i); }
+
+    uint32_t index() const { return i; }
+
+    bool empty() const { return i == 0; }
+
+    bool operator==(const Symbol&) const = default;
+
+    /// Distinct names interned so far, the empty one included
+    static size_t interned() { return pool().size(); }
+};
+
+inline std::ostream& operator<<(std::ostream& os, Symbol s) {
+    return os << s.str();
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstring>
+#include <bit>
+#include <iterator>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define PULSAR_TOKENIZER_SSE2
+#endif
+
+/// @return Pointer to the first `sep`, `'` or `"` in [p, end), or `end`
+inline const char* find_token_break(const char* p, const char* end, char sep) {
+#ifdef PULSAR_TOKENIZER_SSE2
+    const __m128i v_sep = _mm_set1_epi8(sep);
+    const __m128i v_quot = _mm_set1_epi8('\'');
+    const __m128i v_quot2 = _mm_set1_epi8('"');
+
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_or_si128(
+            _mm_cmpeq_epi8(block, v_sep),
+            _mm_or_si128(_mm_cmpeq_epi8(block, v_quot), _mm_cmpeq_epi8(block, v_quot2))
+        );
+
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+        if (mask) return p + std::countr_zero(mask);
+        p += 16;
+    }
+#endif
+    for (; p < end; p++) {
+        if (*p == sep || *p == '\'' || *p == '"') return p;
+    }
+    return end;
+}
+
+/// Lazy splitter with the same rules as split():
+/// empty tokens are skipped, '...' and "..." keep separators inside a token,
+/// the quote characters themselves are dropped.
+///
+/// Tokens are std::string_view's into the source buffer, nothing is allocated.
+/// Quote characters are removed by shifting the token in place, so the buffer
+/// is modified and the views stay valid for as long as the buffer lives.
+class Tokenizer {
+private:
+    char* first;
+    char* last;
+    char sep;
+
+public:
+    class iterator {
+    private:
+        char* pos = nullptr;
+        char* end = nullptr;
+        char sep = ' ';
+        std::string_view current;
+        bool done = true;
+
+        // Moves [from, to) down to `out` (out <= from) and returns the new write position
+        static char* shift(char* out, const char* from, const char* to) {
+            if (out != from) std::memmove(out, from, to - from);
+            return out + (to - from);
+        }
+
+        void next() {
+            while (pos != end) {
+                char* start = pos;
+                char* out = pos;
+                char quote = 0;
+
+                while (pos != end) {
+                    if (!quote) {
+                        auto hit = const_cast<char*>(find_token_break(pos, end, sep));
+                        out = shift(out, pos, hit);
+                        pos = hit;
+                        if (pos == end) break;
+
+                        char c = *pos++;
+                        if (c == sep) break;
+                        quote = c;
+                    } else {
+                        auto hit = static_cast<char*>(std::memchr(pos, quote, end - pos));
+                        if (!hit) hit = end;
+                        out = shift(out, pos, hit);
+                        pos = hit;
+                        if (pos == end) break;
+
+                        pos++;
+                        quote = 0;
+                    }
+                }
+
+                if (out != start) {
+                    current = std::string_view(start, out - start);
+                    return;
+                }
+            }
+            done = true;
+        }
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = const std::string_view&;
+
+        iterator() = default;
+
+        iterator(char* first, char* last, char sep) : pos(first), end(last), sep(sep), done(false) {
+            next();
+        }
+
+        reference operator*() const { return current; }
+        pointer operator->() const { return &current; }
+
+        iterator& operator++() {
+            next();
+            return *this;
+        }
+
+        void operator++(int) { next(); }
+
+        friend bool operator==(const iterator& it, std::default_sentinel_t) { return it.done; }
+    };
+
+    Tokenizer(char* first, char* last, char sep = ' ') : first(first), last(last), sep(sep) {}
+
+    Tokenizer(std::string& str, char sep = ' ') : Tokenizer(str.data(), str.data() + str.size(), sep) {}
+
+    iterator begin() const { return iterator(first, last, sep); }
+    std::default_sentinel_t end() const { return {}; }
+
+    std::vector<std::string> to_vector() const {
+        std::vector<std::string> result;
+        for (auto token : *this) result.emplace_back(token);
+        return result;
+    }
+};
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "../defines"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Scoped spans written as Chrome trace-event JSON (open in ui.perfetto.dev or chrome://tracing).
+// Compiled out unless PULSAR_TRACE is defined: the macros below expand to nothing.
+//
+// Every thread appends to its own fixed buffer without locks, Trace::write() collects them at exit.
+// Span names must be string literals; `detail` is copied (truncated) and shown as an argument.
+namespace Trace {
+    using Clock = std::chrono::steady_clock;
+
+    enum class Kind : char {
+        Complete,       // "X", a scope on one thread
+        AsyncBegin,     // "b", may end on another thread (coroutines)
+        AsyncEnd        // "e"
+    };
+
+    struct Event {
+        const char* name;
+        Kind kind;
+        uint64_t start_ns;
+        uint64_t dur_ns;
+        uint64_t id;                    // async spans only
+        char detail[40];
+    };
+
+    // One per thread, written only by its owner; `count` publishes the events to the reader
+    struct Buffer {
+        uint32_t tid;
+        std::string thread_name;
+        std::atomic<size_t> count = 0;
+        std::atomic<size_t> dropped = 0;
+        std::unique_ptr<Event[]> events = std::make_unique<Event[]>(PULSAR_TRACE_EVENTS_PER_THREAD);
+    };
+
+    struct Registry {
+        std::mutex mtx;                 // taken once per thread, on its first event
+        std::vector<std::unique_ptr<Buffer>> buffers;
+        Clock::time_point epoch = Clock::now();
+        std::atomic<uint64_t> next_async_id = 0;
+
+        static Registry& get() {
+            static Registry registry;
+            return registry;
+        }
+    };
+
+    inline Buffer& buffer() {
+        thread_local Buffer* local = [] {
+            auto& r = Registry::get();
+            std::lock_guard lk(r.mtx);
+            auto& b = r.buffers.emplace_back(std::make_unique<Buffer>());
+            b->tid = (uint32_t)r.buffers.size();
+            return b.get();
+        }();
+        return *local;
+    }
+
+    inline uint64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - Registry::get().epoch).count();
+    }
+
+    inline void record(const char* name, Kind kind, uint64_t start, uint64_t dur, uint64_t id, std::string_view detail) {
+        auto& b = buffer();
+        size_t n = b.count.load(std::memory_order_relaxed);
+        if (n == PULSAR_TRACE_EVENTS_PER_THREAD) {
+            b.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        auto& e = b.events[n];
+        e.name = name;
+        e.kind = kind;
+        e.start_ns = start;
+        e.dur_ns = dur;
+        e.id = id;
+        size_t len = std::min(detail.size(), sizeof(e.detail) - 1);
+        std::memcpy(e.detail, detail.data(), len);
+        e.detail[len] = 0;
+
+        b.count.store(n + 1, std::memory_order_release);
+    }
+
+    /// Names the calling thread in the trace, call it before its first span
+    inline void setThreadName(const char* name) {
+        buffer().thread_name = name;
+    }
+
+    class Span {
+    private:
+        const char* name;
+        uint64_t start = now();
+        char detail[40] = {};
+    public:
+        explicit Span(const char* name, std::string_view text = {}) : name(name) {
+            size_t len = std::min(text.size(), sizeof(detail) - 1);
+            std::memcpy(detail, text.data(), len);
+        }
+
+        ~Span() { record(name, Kind::Complete, start, now() - start, 0, detail); }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+    };
+
+    /// Span of a coroutine, begins and ends on whatever threads it runs on
+    class AsyncSpan {
+    private:
+        const char* name;
+        uint64_t id = Registry::get().next_async_id.fetch_add(1, std::memory_order_relaxed) + 1;
+    public:
+        explicit AsyncSpan(const char* name, std::string_view text = {}) : name(name) {
+            record(name, Kind::AsyncBegin, now(), 0, id, text);
+        }
+
+        ~AsyncSpan() { record(name, Kind::AsyncEnd, now(), 0, id, {}); }
+
+        AsyncSpan(const AsyncSpan&) = delete;
+        AsyncSpan& operator=(const AsyncSpan&) = delete;
+    };
+
+    inline void writeEscaped(std::ostream& os, std::string_view text) {
+        for (unsigned char c : text) {
+            if (c == '"' || c == '\\') os << '\\' << c;
+            else if (c < 0x20) os << ' ';
+            else os << c;
+        }
+    }
+
+    /// Writes everything recorded so far. Threads may keep tracing meanwhile, their newer events are left out.
+    inline bool write(const std::string& path) {
+        std::ofstream out(path, std::ios::trunc);
+        if (!out) return false;
+
+        auto& r = Registry::get();
+        std::lock_guard lk(r.mtx);
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+        auto sep = [&] {
+            if (!first) out << ",\n";
+            first = false;
+        };
+
+        for (auto& b : r.buffers) {
+            if (!b->thread_name.empty()) {
+                sep();
+                out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << b->tid << ",\"args\":{\"name\":\"";
+                writeEscaped(out, b->thread_name);
+                out << "\"}}";
+            }
+
+            size_t n = b->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < n; i++) {
+                auto& e = b->events[i];
+                sep();
+                out << "{\"name\":\"";
+                writeEscaped(out, e.name);
+                out << "\",\"cat\":\"pulsar\",\"pid\":1,\"tid\":" << b->tid << ",\"ts\":" << e.start_ns / 1000.0;
+
+                switch (e.kind) {
+                    case Kind::Complete: out << ",\"ph\":\"X\",\"dur\":" << e.dur_ns / 1000.0; break;
+                    case Kind::AsyncBegin: out << ",\"ph\":\"b\",\"id\":" << e.id; break;
+                    case Kind::AsyncEnd: out << ",\"ph\":\"e\",\"id\":" << e.id; break;
+                }
+
+                if (e.detail[0]) {
+                    out << ",\"args\":{\"detail\":\"";
+                    writeEscaped(out, e.detail);
+                    out << "\"}";
+                }
+                out << '}';
+            }
+
+            if (auto dropped = b->dropped.load(std::memory_order_relaxed)) {
+                sep();
+                out << "{\"ph\":\"i\",\"s\":\"t\",\"name\":\"trace buffer full, " << dropped << " events dropped\",\"pid\":1,\"tid\":" << b->tid << ",\"ts\":0}";
+            }
+        }
+
+        out << "\n]}\n";
+        return (bool)out;
+    }
+}
+
+#define PULSAR_TRACE_CONCAT2(a, b) a##b
+#define PULSAR_TRACE_CONCAT(a, b) PULSAR_TRACE_CONCAT2(a, b)
+
+#ifdef PULSAR_TRACE
+    /// PULSAR_TRACE_SCOPE("login") or PULSAR_TRACE_SCOPE("sqlite", sql) - span until the end of the scope
+#   define PULSAR_TRACE_SCOPE(...) Trace::Span PULSAR_TRACE_CONCAT(pulsar_trace_span_, __LINE__) { __VA_ARGS__ }
+    /// Same for coroutines, which may resume on another thread
+#   define PULSAR_TRACE_ASYNC(...) Trace::AsyncSpan PULSAR_TRACE_CONCAT(pulsar_trace_span_, __LINE__) { __VA_ARGS__ }
+#   define PULSAR_TRACE_THREAD(name) Trace::setThreadName(name)
+#else
+#   define PULSAR_TRACE_SCOPE(...)
+#   define PULSAR_TRACE_ASYNC(...)
+#   define PULSAR_TRACE_THREAD(name)
+#endif
@@ -1,34 +1,12 @@
 #pragma once
 
 #include <string>
-#include <sstream>
-#include <iomanip>
+#include <string_view>
+#include <cstdint>
 
-uint32_t fnv1a(const std::string& str) {
-    uint32_t hash = 0x811C9DC5; // FNV offset basis
-    for (char c : str) {
-        hash ^= static_cast<uint8_t>(c);
-        hash *= 0x01000193; // FNV prime
-    }
-    return hash;
-}
+uint32_t fnv1a(std::string_view str);
 
-std::string hasher(const std::string& input) {
-    uint32_t h1 = fnv1a(PULSAR_SALT + input);
-    uint32_t h2 = fnv1a(input + PULSAR_SALT);
-    
-    std::string combined = std::to_string(h1) + std::to_string(h2);
-    uint32_t finalHash = fnv1a(combined);
+std::string hasher(const std::string& input);
 
-    std::stringstream ss;
-    ss << std::hex << finalHash;
-    return ss.str();
-}
-
-std::string hash(const std::string& unhashed) {
-    std::string current = unhashed;
-    for (int i = 0; i < PULSAR_HASH_ITERATIONS; ++i) {
-        current = hasher(current);
-    }
-    return current;
-}
+/// PULSAR_HASH_ITERATIONS rounds of hasher() over the salted input
+std::string hash(const std::string& unhashed);
@@ -3,8 +3,11 @@
 #include "Network/Client.hpp"
 #include "Network/Encryption.hpp"
 #include "Network/Checker.hpp"
+#include "Other/Metrics.hpp"
+#include "Other/Trace.hpp"
 #include <exception>
 #include <csignal>
+#include <cstdlib>
 
 #ifdef _WIN32
 #   include <windows.h>
@@ -15,6 +18,7 @@
 #endif
 
 int main(int argc, const char **argv) {
+    PULSAR_TRACE_THREAD("main");
 #ifdef _WIN32
     SetConsoleCP(65001); // Russian UTF-8 support
     SetConsoleOutputCP(65001);
@@ -52,9 +56,19 @@ int main(int argc, const char **argv) {
     if (!rsa_test(PULSAR_RSA_TEST)) return -1;
 #endif
 
+    // Headless bridges can be scraped through the node_exporter textfile collector
+    if (const char* metrics_file = std::getenv("PULSAR_METRICS_FILE")) {
+        Metrics::Registry::global().startDump(metrics_file, std::chrono::milliseconds(PULSAR_METRICS_INTERVAL_MS));
+    }
+
     Client client(name, password, serverIP, PULSAR_PORT);
     client.run();
 
+#ifdef PULSAR_TRACE
+    const char* trace_file = std::getenv("PULSAR_TRACE_FILE");
+    Trace::write(trace_file ? trace_file : "pulsar-trace.json");
+#endif
+
     std::cout << "Клиент завершил свою работу." << std::endl;
 
     return 0;
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Minimal test harness for pulsar-tests.
+// Tests register themselves with PULSAR_TEST and are run from tests/main.cpp,
+// each in an empty working directory of its own (databases and downloads are created in the current one).
+namespace test {
+    struct Case {
+        std::string name;
+        std::function<void()> fn;
+    };
+
+    inline std::vector<Case>& registry() {
+        static std::vector<Case> cases;
+        return cases;
+    }
+
+    struct Registrar {
+        Registrar(const std::string& name, std::function<void()> fn) {
+            registry().push_back({ name, std::move(fn) });
+        }
+    };
+
+    /// Failed checks of the running test
+    inline size_t& failures() {
+        static size_t count = 0;
+        return count;
+    }
+
+    inline bool check(bool ok, const char* expr, const char* file, int line) {
+        if (!ok) {
+            std::cout << "  " << file << ":" << line << ": failed: " << expr << std::endl;
+            failures()++;
+        }
+        return ok;
+    }
+};
+
+#define PULSAR_TEST_CONCAT2(a, b) a##b
+#define PULSAR_TEST_CONCAT(a, b) PULSAR_TEST_CONCAT2(a, b)
+
+/// Declares a test: PULSAR_TEST("tokenizer") { PULSAR_CHECK(...); }
+#define PULSAR_TEST(name) \
+    static void PULSAR_TEST_CONCAT(pulsar_test_, __LINE__)(); \
+    static test::Registrar PULSAR_TEST_CONCAT(pulsar_test_reg_, __LINE__) { name, PULSAR_TEST_CONCAT(pulsar_test_, __LINE__) }; \
+    static void PULSAR_TEST_CONCAT(pulsar_test_, __LINE__)()
+
+/// Records a failure and goes on with the test; evaluates to `cond`
+#define PULSAR_CHECK(cond) test::check(static_cast<bool>(cond), #cond, __FILE__, __LINE__)
@@ -0,0 +1,46 @@
+#include "Test.hpp"
+#include "../bench/Legacy.hpp"
+#include "Network/Checker.hpp"
+#include <random>
+
+// The character class table (and its SSE2 scan, where compiled in) accepts exactly what the old checker did
+PULSAR_TEST("checker") {
+    const std::vector<std::string> names = {
+        "@matmal29", "@a", "@some_long_user_name_1234567890", "@admin", "@Upper", "@with space",
+        "@user;drop", "@all", "@x_y_z", "@пользователь", "@browser", "@12345678901234567890123456789012",
+        "@123456789012345678901234567890123", ":all", ":server", ":browser", ":chan:nel", ":a@b", "@a:b",
+        "", "@", ":", "admin", "@ADMIN", "@admin2", "@serve", "@tab\there", std::string("@null\0byte", 10)
+    };
+    for (auto& n : names) {
+        if (!PULSAR_CHECK(Checker::checkUsername(n) == legacy::checkUsername(n))) std::cout << "  username '" << n << "'" << std::endl;
+        if (!PULSAR_CHECK(Checker::checkChannelName(n) == legacy::checkChannelName(n))) std::cout << "  channel '" << n << "'" << std::endl;
+    }
+
+    // Every byte value at every position of names long enough for the 16-byte blocks and their tails
+    for (size_t length : { 2, 15, 16, 17, 31, 32, 33 }) {
+        for (size_t pos = 1; pos < length; pos++) {
+            for (int c = 0; c < 256; c++) {
+                for (char first : { '@', ':' }) {
+                    std::string n(length, 'a');
+                    n[0] = first;
+                    n[pos] = (char)c;
+                    PULSAR_CHECK(Checker::checkUsername(n) == legacy::checkUsername(n));
+                    PULSAR_CHECK(Checker::checkChannelName(n) == legacy::checkChannelName(n));
+                }
+            }
+        }
+    }
+
+    // Random names over the characters that matter, most of them valid up to one character
+    const std::string alphabet = "abcxyz019_@:!;. \"'-AZ\x7f\x80\xd0\xbf";
+    std::mt19937 rng(29);
+    for (int i = 0; i < 200000; i++) {
+        std::string n(1 + rng() % 40, 'a');
+        n[0] = rng() % 2 ? '@' : ':';
+        for (size_t k = 1; k < n.size(); k++) {
+            if (rng() % 8 == 0) n[k] = alphabet[rng() % alphabet.size()];
+        }
+        PULSAR_CHECK(Checker::checkUsername(n) == legacy::checkUsername(n));
+        PULSAR_CHECK(Checker::checkChannelName(n) == legacy::checkChannelName(n));
+    }
+}
@@ -0,0 +1,97 @@
+#include "Test.hpp"
+#include "Network/Database.hpp"
+
+static int userVersion(const std::string& path) {
+    SQLite3Database db(path);
+    int version = -1;
+    db.query("PRAGMA user_version;", [&](const SQLite3Database::Row& row) { version = std::stoi(row[0]); });
+    return version;
+}
+
+// A file written before the schema was versioned: the tables of the time, some rows in them, user_version 0
+PULSAR_TEST("database migrations") {
+    const std::string path = "pulsar_@me.db";
+    {
+        SQLite3Database db(path);
+        db.execute(
+            "CREATE TABLE profile (username TEXT PRIMARY KEY, name TEXT, email TEXT, description TEXT, birthday INTEGER, status TEXT);"
+            "CREATE TABLE channels (username TEXT, channel TEXT, PRIMARY KEY(username, channel));"
+            "CREATE TABLE contacts (username TEXT, contact_username TEXT, contact_name TEXT, PRIMARY KEY(username, contact_username));"
+            "CREATE TABLE unread (username TEXT, id INTEGER, time INTEGER, src TEXT, dst TEXT, msg TEXT, PRIMARY KEY(username, id, src, dst));"
+            "CREATE TABLE outbox (seq INTEGER PRIMARY KEY AUTOINCREMENT, username TEXT, time INTEGER, dst TEXT, msg TEXT);"
+            "CREATE TABLE last_seen (username TEXT, chat TEXT, id INTEGER, PRIMARY KEY(username, chat));"
+            "INSERT INTO profile VALUES ('@me', 'Me', '', '', 0, 'active');"
+            "INSERT INTO channels VALUES ('@me', ':general');"
+            "INSERT INTO contacts VALUES ('@me', '@bob', 'Bob');"
+            "INSERT INTO unread VALUES ('@me', 1, 100, '@bob', ':general', 'hello there');"
+            "INSERT INTO unread VALUES ('@me', 2, 101, '@ann', ':general', 'general kenobi');"
+            "INSERT INTO unread VALUES ('@me', 7, 102, '@bob', '@me', 'a direct message');"
+            "INSERT INTO last_seen VALUES ('@me', ':general', 2);"
+        );
+    }
+    PULSAR_CHECK(userVersion(path) == 0);
+
+    {
+        Database db("@me");
+        PULSAR_CHECK(userVersion(path) == 6);
+
+        // old rows are still there, and the caches are filled from them
+        PULSAR_CHECK(db.is_channel_member(":general"));
+        PULSAR_CHECK(db.contact_name("@bob") == "Bob");
+        PULSAR_CHECK(db.get_last_seen()[":general"] == 2);
+
+        // 4: counts of the unread rows that were already there
+        PULSAR_CHECK(db.unread_count() == 3);
+        PULSAR_CHECK(db.unread_count(":general") == 2);
+        PULSAR_CHECK(db.unread_count("@me") == 1);
+
+        // 3: read marks; 4: the triggers keep the counts
+        db.read_up_to(":general", 1);
+        PULSAR_CHECK(db.unread_count(":general") == 1);
+        db.store_unread(Message { 1, 100, "@bob", ":general", "hello there" });     // below the mark
+        PULSAR_CHECK(db.unread_count(":general") == 1);
+
+        // 5: unread rows copied into the history, a direct message under its sender
+        PULSAR_CHECK(db.search("kenobi").size() == 1);
+        auto direct = db.search("direct");
+        PULSAR_CHECK(direct.size() == 1 && direct[0].get_id() == 7);
+        PULSAR_CHECK(db.history("@bob").size() == 1);
+        PULSAR_CHECK(db.history(":general").size() == 2);
+
+        // 6: partial transfers
+        db.save_transfer({ "@bob", "0123abcd", "file.bin", 1000, 765, 1, "0" });
+        auto t = db.load_transfer("@bob", "0123abcd");
+        PULSAR_CHECK(t && t->name == "file.bin" && t->next == 1);
+    }
+
+    // Opening again runs no step twice
+    {
+        Database db("@me");
+        PULSAR_CHECK(userVersion(path) == 6);
+        PULSAR_CHECK(db.unread_count() == 2);
+        PULSAR_CHECK(db.history(":general").size() == 2);
+    }
+
+    // A file from a newer client is left as it is
+    {
+        SQLite3Database db(path);
+        db.execute("PRAGMA user_version = 99;");
+    }
+    {
+        Database db("@me");
+        PULSAR_CHECK(userVersion(path) == 99);
+        PULSAR_CHECK(db.unread_count() == 2);
+    }
+}
+
+// A new file goes through every step
+PULSAR_TEST("database new file") {
+    Database db("@new");
+    PULSAR_CHECK(userVersion("pulsar_@new.db") == 6);
+    PULSAR_CHECK(db.unread_count() == 0);
+
+    db.store_unread(Message { 3, 100, "@bob", "@new", "hi" });
+    PULSAR_CHECK(db.unread_count("@new") == 1);
+    db.read_up_to("@new", 3);
+    PULSAR_CHECK(db.unread_count() == 0);
+}
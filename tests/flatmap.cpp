@@ -0,0 +1,55 @@
+#include "Test.hpp"
+#include "Other/FlatMap.hpp"
+#include <map>
+#include <random>
+
+// Erase shifts the rest of a probe run back instead of leaving tombstones: every key must stay reachable
+PULSAR_TEST("flatmap") {
+    FlatMap<int> map;
+    PULSAR_CHECK(!map.erase("none"));
+    PULSAR_CHECK(map.find("none") == nullptr);
+
+    map["a"] = 1;
+    map.insert_or_assign("b", 2);
+    map.insert_or_assign("a", 3);
+    PULSAR_CHECK(map.size() == 2);
+    PULSAR_CHECK(map.find("a") && *map.find("a") == 3);
+    PULSAR_CHECK(map.erase("a"));
+    PULSAR_CHECK(!map.erase("a"));
+    PULSAR_CHECK(!map.contains("a") && map.contains("b"));
+
+    // Random inserts and erases against std::map, with few enough keys that probe runs are long and wrap around
+    map.clear();
+    std::map<std::string, int> model;
+    std::mt19937 rng(41);
+    for (int i = 0; i < 200000; i++) {
+        auto key = ":chat" + std::to_string(rng() % 200);
+        if (rng() % 3 == 0) {
+            PULSAR_CHECK(map.erase(key) == (model.erase(key) > 0));
+        } else {
+            map.insert_or_assign(key, i);
+            model[key] = i;
+        }
+
+        if (i % 1000 == 0) {
+            PULSAR_CHECK(map.size() == model.size());
+            for (int k = 0; k < 200; k++) {
+                auto probe = ":chat" + std::to_string(k);
+                auto it = model.find(probe);
+                auto value = map.find(probe);
+                PULSAR_CHECK((value != nullptr) == (it != model.end()));
+                if (value && it != model.end()) PULSAR_CHECK(*value == it->second);
+            }
+        }
+    }
+
+    size_t visited = 0;
+    map.for_each([&](const std::string& key, int value) {
+        visited++;
+        PULSAR_CHECK(model.count(key) && model[key] == value);
+    });
+    PULSAR_CHECK(visited == model.size());
+
+    for (auto& [key, value] : model) PULSAR_CHECK(map.erase(key));
+    PULSAR_CHECK(map.empty());
+}
@@ -0,0 +1,105 @@
+#include "Test.hpp"
+#include "Network/MessageLog.hpp"
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+static Message logMessage(size_t id, const std::string& chat) {
+    return Message { id, 1700000000 + (time_t)id, "@u" + std::to_string(id % 7), chat, "text " + std::to_string(id) };
+}
+
+// Every id of `chat` from `first` to `last` in `step`s, once each and in order
+static bool complete(MessageLog& log, const std::string& chat, size_t first, size_t last, size_t step) {
+    auto all = log.history(chat, std::numeric_limits<size_t>::max(), 1000000);
+    size_t id = first;
+    for (auto& msg : all) {
+        if (msg.get_id() != id || msg.get_msg() != "text " + std::to_string(id)) return false;
+        id += step;
+    }
+    return id == last + step;
+}
+
+static fs::path newestSegment(const fs::path& dir) {
+    fs::path newest;
+    for (auto& file : fs::directory_iterator(dir)) {
+        if (file.path().extension() == ".log" && file.path() > newest) newest = file.path();
+    }
+    return newest;
+}
+
+// A crash leaves the active segment unsealed, possibly ending in a torn record: it is cut after the last intact one
+PULSAR_TEST("message log recovery") {
+    {
+        MessageLog log("log", "@me");
+        for (size_t b = 0; b < 10; b++) {
+            std::vector<Message> batch;
+            for (size_t id = b * 10 + 1; id <= b * 10 + 10; id++) batch.push_back(logMessage(id, ":c"));
+            log.store_history(batch);
+        }
+        log.store_history({ Message { 1, 1, "@bob", "@me", "text 1" } });      // kept under the sender
+
+        // what a crash right now leaves on disk: no seal, no footer
+        fs::copy("log", "crashed", fs::copy_options::recursive);
+        fs::copy("log", "torn", fs::copy_options::recursive);
+    }
+
+    {
+        std::ofstream out(newestSegment("crashed"), std::ios::binary | std::ios::app);
+        out << "half of a record";
+    }
+    {
+        MessageLog log("crashed", "@me");
+        PULSAR_CHECK(complete(log, ":c", 1, 100, 1));
+        PULSAR_CHECK(log.history("@bob").size() == 1);
+
+        log.store_history({ logMessage(101, ":c") });
+        PULSAR_CHECK(complete(log, ":c", 1, 101, 1));
+    }
+    {
+        MessageLog log("crashed", "@me");
+        PULSAR_CHECK(complete(log, ":c", 1, 101, 1));
+    }
+
+    // the last record written only in part
+    auto segment = newestSegment("torn");
+    fs::resize_file(segment, fs::file_size(segment) - 3);
+    {
+        MessageLog log("torn", "@me");
+        PULSAR_CHECK(complete(log, ":c", 1, 100, 1));
+        PULSAR_CHECK(log.history("@bob").empty());
+    }
+}
+
+// Sealed segments of about the same size are merged in the background, a resend stored twice is kept once
+PULSAR_TEST("message log compaction") {
+    // 50 messages of 56 bytes: more than half a segment, so every batch ends up in a segment of its own
+    auto batch = [](size_t b) {
+        std::vector<Message> out;
+        for (size_t id = 1001 + b * 50; id <= 1050 + b * 50; id++) out.push_back(logMessage(id, ":c" + std::to_string(id % 2)));
+        return out;
+    };
+
+    {
+        MessageLog log("log", "@me", 4096);
+        // 16 sealed and the active one: four merges of four, then one of their four outputs
+        for (size_t b = 0; b < 16; b++) {
+            log.store_history(batch(b));
+            if (b == 8) log.store_history(batch(b - 1));
+        }
+
+        for (int i = 0; i < 500 && log.segments() > 2; i++) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        PULSAR_CHECK(log.segments() == 2);
+        PULSAR_CHECK(complete(log, ":c0", 1002, 1800, 2));
+        PULSAR_CHECK(complete(log, ":c1", 1001, 1799, 2));
+    }
+
+    size_t files = 0;
+    for (auto& file : fs::directory_iterator("log")) files += file.path().extension() == ".log";
+    PULSAR_CHECK(files == 2);
+
+    MessageLog log("log", "@me", 4096);
+    PULSAR_CHECK(complete(log, ":c0", 1002, 1800, 2));
+    PULSAR_CHECK(complete(log, ":c1", 1001, 1799, 2));
+}
@@ -0,0 +1,42 @@
+#include "Test.hpp"
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+// Usage: pulsar-tests [filter]
+// Runs every registered test whose name contains `filter`, returns 1 if any of them failed.
+int main(int argc, const char** argv) {
+    const char* filter = argc > 1 ? argv[1] : "";
+
+    const auto home = fs::current_path();
+    const auto scratch = fs::temp_directory_path() / ("pulsar-tests-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+
+    size_t run = 0, failed = 0;
+    for (auto& c : test::registry()) {
+        if (c.name.find(filter) == std::string::npos) continue;
+
+        fs::remove_all(scratch);
+        fs::create_directories(scratch);
+        fs::current_path(scratch);
+
+        std::cout << "[" << c.name << "]" << std::endl;
+        test::failures() = 0;
+        try {
+            c.fn();
+        } catch (const std::exception& e) {
+            std::cout << "  exception: " << e.what() << std::endl;
+            test::failures()++;
+        }
+
+        run++;
+        if (test::failures()) failed++;
+        fs::current_path(home);
+    }
+    fs::remove_all(scratch);
+
+    std::cout << run - failed << " of " << run << " tests passed" << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,55 @@
+#include "Test.hpp"
+#include "Other/SeenFilter.hpp"
+#include <random>
+#include <set>
+
+PULSAR_TEST("seen filter") {
+    SeenFilter f;
+    PULSAR_CHECK(f.note("a", 5));
+    PULSAR_CHECK(!f.note("a", 5));
+    PULSAR_CHECK(f.note("a", 3));           // late, but not seen
+    PULSAR_CHECK(!f.note("a", 3));
+    PULSAR_CHECK(f.note("b", 5));           // chats are apart
+    PULSAR_CHECK(f.note("a", 0) && f.note("a", 0));     // not a real id
+
+    // Moving the window forward forgets what fell out of it and clears the ids skipped over
+    PULSAR_CHECK(f.note("a", 5 + PULSAR_SEEN_WINDOW));
+    PULSAR_CHECK(!f.note("a", 5));          // older than the window counts as seen
+    PULSAR_CHECK(f.note("a", 4 + PULSAR_SEEN_WINDOW));
+    PULSAR_CHECK(f.note("a", 6));
+    PULSAR_CHECK(f.newest("a") == 5 + PULSAR_SEEN_WINDOW);
+    PULSAR_CHECK(f.newest("none") == 0);
+
+    // Ids reordered by up to 500 against a set of everything seen
+    std::mt19937 rng(50);
+    std::set<size_t> seen;
+    SeenFilter g;
+    size_t newest = 0;
+    for (int i = 0; i < 200000; i++) {
+        size_t id = (newest > 500 ? newest - 500 : 1) + rng() % 600;
+        bool fresh = seen.insert(id).second;
+        newest = std::max(newest, id);
+        PULSAR_CHECK(g.note("c", id) == fresh);
+    }
+
+    // Restored marks only carry over to marks(), where a resume starts fetching
+    SeenFilter r;
+    r.restore({ { ":x", 10 }, { ":y", 7 }, { ":zero", 0 } });
+    PULSAR_CHECK(r.size() == 0);
+    auto marks = r.marks();
+    PULSAR_CHECK(marks.size() == 2 && marks[":x"] == 10 && marks[":y"] == 7);
+
+    // The server's ids started over since the marks were saved: nothing below them is dropped
+    for (size_t id = 1; id <= 12; id++) PULSAR_CHECK(r.note(":x", id));
+    PULSAR_CHECK(!r.note(":x", 1));
+    PULSAR_CHECK(!r.note(":x", 12));
+    PULSAR_CHECK(r.note(":y", 1));
+    marks = r.marks();
+    PULSAR_CHECK(marks.size() == 2 && marks[":x"] == 12 && marks[":y"] == 1);
+
+    SeenFilter unseen;
+    unseen.restore({ { ":all", 20000 } });
+    PULSAR_CHECK(unseen.note(":all", 20000));
+    PULSAR_CHECK(!unseen.note(":all", 20000));
+    PULSAR_CHECK(unseen.marks()[":all"] == 20000);
+}
@@ -0,0 +1,40 @@
+#include "Test.hpp"
+#include "../bench/Legacy.hpp"
+#include "Other/Chat.hpp"
+#include <random>
+
+// Tokenizer and split() built on it give the same tokens as the old split()
+PULSAR_TEST("tokenizer") {
+    const std::vector<std::string> commands = {
+        "", " ", "   ", "!exit", "!contact add @someone 'Some Long Name'", "  leading and  double  spaces ",
+        "\"double 'nested' quotes\" after", "'single \"nested\" quotes' after", "'unterminated quote here",
+        "\"unterminated double", "''", "\"\"", "a''b", "'' ''", "quote'in'middle", "end'", "'",
+        "!search \"full text\" :all", "sixteen-bytes-ab sixteen-bytes-cd 'a quote spanning a block boundary'"
+    };
+    for (auto& c : commands) {
+        if (!PULSAR_CHECK(split(c) == legacy::split(c))) std::cout << "  on '" << c << "'" << std::endl;
+    }
+
+    // Random text with separators and both quotes, for ' ' and PULSAR_SEP
+    const std::string alphabet = "ab c'\"\x1f";
+    std::mt19937 rng(28);
+    for (int i = 0; i < 100000; i++) {
+        std::string s(rng() % 70, ' ');
+        for (auto& c : s) c = rng() % 4 ? 'x' : alphabet[rng() % alphabet.size()];
+        for (char sep : { ' ', PULSAR_SEP }) {
+            std::string buffer = s;
+            auto tokens = Tokenizer(buffer, sep).to_vector();
+            if (!PULSAR_CHECK(tokens == legacy::split(s, sep))) std::cout << "  on '" << s << "'" << std::endl;
+        }
+    }
+
+    // A !chat history, lines joined with PULSAR_SEP
+    std::string history;
+    for (size_t i = 1; i <= 1000; i++) {
+        history += Message { i, 1700000000 + (time_t)i, "@user" + std::to_string(i % 30), ":all", "line " + std::to_string(i) }.to_payload();
+        history += PULSAR_SEP;
+    }
+    auto lines = split(history, PULSAR_SEP);
+    PULSAR_CHECK(lines == legacy::split(history, PULSAR_SEP));
+    PULSAR_CHECK(lines.size() == 1000);
+}
@@ -0,0 +1,162 @@
+#include "Test.hpp"
+#include "API/Transfers.hpp"
+#include <deque>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+// Two users' Transfers joined by an in-order queue that stands in for the server
+struct Link {
+    struct Sent {
+        std::string from, to, text;
+    };
+
+    std::deque<Sent> wire;
+    std::function<bool(const Sent&)> lose = [](const Sent&) { return false; };
+    size_t chunks_sent = 0;
+    std::vector<Message> notices;
+
+    Database db_a { "@a" }, db_b { "@b" };
+    std::unique_ptr<Transfers> a, b;
+
+    Link() { connect(); }
+
+    // New Transfers on both sides, as after a restart of both clients
+    void connect() {
+        a.reset();
+        b.reset();
+        wire.clear();
+        a = std::make_unique<Transfers>(db_a, "@a", sender("@a"), [this](const Message& msg) { notices.push_back(msg); });
+        b = std::make_unique<Transfers>(db_b, "@b", sender("@b"), [this](const Message& msg) { notices.push_back(msg); });
+    }
+
+    Transfers::Send sender(std::string from) {
+        return [this, from](const std::string& peer, const std::string& text, bool) {
+            if (text.size() > 5 && text[5] == 'C') chunks_sent++;
+            wire.push_back({ from, peer, text });
+            return true;
+        };
+    }
+
+    /// Delivers what is on the wire, `limit` messages at most
+    void deliver(size_t limit = SIZE_MAX) {
+        for (size_t n = 0; n < limit && !wire.empty(); n++) {
+            auto sent = std::move(wire.front());
+            wire.pop_front();
+            if (lose(sent)) continue;
+            (sent.to == "@a" ? *a : *b).handle(Message { 0, 0, sent.from, sent.to, sent.text });
+        }
+    }
+
+    /// Delivers and repeats whatever is unanswered until the sender has nothing left to do
+    void finish() {
+        for (int round = 0; round < 100; round++) {
+            deliver();
+            if (!a->tick(std::chrono::seconds(0))) break;
+        }
+        deliver();
+    }
+};
+
+static std::string readFile(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream out;
+    out << in.rdbuf();
+    return out.str();
+}
+
+// Every byte value, in an order that differs with the size
+static fs::path makeFile(const std::string& name, size_t size) {
+    fs::create_directories("out");
+    std::string bytes(size, '\0');
+    for (size_t i = 0; i < size; i++) bytes[i] = (char)(i * 131 + size);
+    std::ofstream(fs::path("out") / name, std::ios::binary) << bytes;
+    return fs::path("out") / name;
+}
+
+static bool received(const fs::path& sent) {
+    auto path = fs::path(PULSAR_TRANSFER_DIR) / "@b" / sent.filename();
+    return fs::exists(path) && readFile(path) == readFile(sent);
+}
+
+static std::string frame(const std::string& body) {
+    auto length = std::to_string(5 + body.size());
+    return PULSAR_XFER + std::string(4 - length.size(), '0') + length + body;
+}
+
+// Chunks go in base64: sizes around the 3-byte groups and the chunk size check the padding and the last chunk
+PULSAR_TEST("transfers round trip") {
+    Link link;
+    for (size_t size : { 1, 2, 3, 4, 5, 764, 765, 766, PULSAR_TRANSFER_CHUNK * 40 + 1 }) {
+        auto path = makeFile("f" + std::to_string(size) + ".bin", size);
+        link.a->sendFile("@b", path);
+        link.finish();
+        if (!PULSAR_CHECK(received(path))) std::cout << "  size " << size << std::endl;
+    }
+    for (auto& t : link.a->list()) PULSAR_CHECK(t.state == Transfers::Done && t.done == t.size);
+
+    std::string text;
+    while (text.size() < 5000) text += "длинное сообщение, ";
+    link.notices.clear();
+    link.a->sendText("@b", text);
+    link.finish();
+    bool shown = false;
+    for (auto& msg : link.notices) shown |= msg.get_src() == "@a" && msg.get_msg() == text;
+    PULSAR_CHECK(shown);
+}
+
+// Lost chunks are noticed from the acks and sent again
+PULSAR_TEST("transfers loss") {
+    Link link;
+    size_t n = 0;
+    link.lose = [&](const Link::Sent& sent) { return sent.text[5] == 'C' && ++n % 7 == 0; };
+
+    auto path = makeFile("lossy.bin", PULSAR_TRANSFER_CHUNK * 100 + 10);
+    link.a->sendFile("@b", path);
+    link.finish();
+    PULSAR_CHECK(n > 100);
+    PULSAR_CHECK(received(path));
+}
+
+// Cut off halfway, then both clients restart: sending the same file again picks up where it stopped
+PULSAR_TEST("transfers resume") {
+    Link link;
+    const size_t chunks = 200;
+    auto path = makeFile("big.bin", PULSAR_TRANSFER_CHUNK * chunks);
+    auto id = link.a->sendFile("@b", path);
+
+    size_t delivered = 0;
+    while (!link.wire.empty() && delivered < chunks / 2) {
+        delivered += link.wire.front().text[5] == 'C';
+        link.deliver(1);
+        if (link.wire.empty()) link.a->tick(std::chrono::seconds(0));
+    }
+    auto partial = link.b->list();
+    PULSAR_CHECK(partial.size() == 1 && partial[0].state == Transfers::Receiving && partial[0].done > 0);
+
+    link.connect();
+    PULSAR_CHECK(link.db_b.load_transfer("@a", id).has_value());
+
+    link.chunks_sent = 0;
+    PULSAR_CHECK(link.a->sendFile("@b", path) == id);
+    link.finish();
+    PULSAR_CHECK(received(path));
+    PULSAR_CHECK(link.chunks_sent <= chunks - delivered + PULSAR_TRANSFER_WINDOW);
+    PULSAR_CHECK(!link.db_b.load_transfer("@a", id).has_value());
+}
+
+// A peer's id names the .part file: only ids of the form the sender makes are taken
+PULSAR_TEST("transfers ids") {
+    Link link;
+    for (std::string id : { "../../x", "0123abc", "0123abcde", "0123ABCD", "0123abc/", "" }) {
+        link.b->handle(Message { 0, 0, "@a", "@b", frame("O " + id + " F 10 765 name") });
+        link.b->handle(Message { 0, 0, "@a", "@b", frame("C " + id + " 0000000000 00000000 AAAA") });
+        link.b->handle(Message { 0, 0, "@a", "@b", frame("E " + id + " 0") });
+    }
+    PULSAR_CHECK(link.b->list().empty());
+    PULSAR_CHECK(link.wire.empty());
+
+    link.b->handle(Message { 0, 0, "@a", "@b", frame("O 0123abcd F 10 765 name") });
+    PULSAR_CHECK(link.b->list().size() == 1);
+}
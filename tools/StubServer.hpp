@@ -0,0 +1,256 @@
+#pragma once
+
+#include "defines"
+#include "Other/Message.hpp"
+#include "Other/Tokenizer.hpp"
+#include "Other/Datetime.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+
+// In-memory implementation of the Pulsar server protocol for local testing.
+// Transport agnostic: the caller feeds every received payload to handle()
+// and sends the produced Outgoing payloads to their sessions.
+//
+// Requests are messages to "!server.req", replies come from "!server.msg"
+// as "REQ:<request>\x1eRSP:<response>", which is what PulsarAPI::parseServer expects.
+class StubServer {
+public:
+    using SessionId = size_t;
+
+    struct Outgoing {
+        SessionId to;
+        std::string payload;
+    };
+
+    /// @param echo Deliver channel messages back to their sender too
+    StubServer(bool echo = false) : echo(echo) {}
+
+    void connected(SessionId id) {
+        sessions[id] = {};
+    }
+
+    void disconnected(SessionId id) {
+        auto it = sessions.find(id);
+        if (it == sessions.end()) return;
+
+        if (!it->second.user.empty()) {
+            auto& list = online[it->second.user];
+            list.erase(std::remove(list.begin(), list.end(), id), list.end());
+        }
+        sessions.erase(it);
+    }
+
+    /// Handles one payload received from session `id`, appends replies and fan-out to `out`
+    void handle(SessionId id, std::string_view payload, std::vector<Outgoing>& out) {
+        Message msg;
+        try {
+            msg = Message::from_payload(payload);
+        } catch (...) {
+            return;
+        }
+
+        stats.received++;
+
+        if (msg.get_dst() == "!server.req") {
+            std::string rsp;
+            try {
+                rsp = request(id, msg.get_msg());
+            } catch (const std::exception&) {
+                rsp = "-";
+            }
+            Message reply { 0, Datetime::now().toTime(), "!server.msg", msg.get_src(), "REQ:" + msg.get_msg() + '\x1e' + "RSP:" + rsp };
+            out.push_back({ id, reply.to_payload() });
+            return;
+        }
+
+        auto& session = sessions[id];
+        if (session.user.empty()) return;
+
+        deliver(id, session.user, msg.get_dst(), msg.get_msg(), out);
+    }
+
+    struct Stats {
+        size_t received = 0;
+        size_t delivered = 0;
+    } stats;
+
+private:
+    struct Session {
+        std::string user;
+    };
+
+    bool echo;
+
+    std::unordered_map<SessionId, Session> sessions;
+    std::unordered_map<std::string, std::vector<SessionId>> online;        // user -> sessions
+    std::unordered_map<std::string, std::string> passwords;                // user -> password hash
+    std::unordered_map<std::string, std::string> profiles;                 // user -> profile payload
+    std::unordered_map<std::string, std::unordered_set<std::string>> members; // channel -> users
+    std::unordered_map<std::string, std::vector<Message>> history;         // chat -> messages, id = index + 1
+    std::unordered_map<std::string, std::set<std::pair<std::string, size_t>>> unread; // user -> (chat, id)
+
+    static std::string dmKey(const std::string& a, const std::string& b) {
+        return a < b ? a + "|" + b : b + "|" + a;
+    }
+
+    // History key of `chat` as seen by `user`
+    static std::string historyKey(const std::string& user, const std::string& chat) {
+        return chat[0] == '@' ? dmKey(user, chat) : chat;
+    }
+
+    void sendTo(const std::string& user, const Message& msg, SessionId except, std::vector<Outgoing>& out) {
+        auto it = online.find(user);
+        if (it == online.end()) return;
+
+        for (auto sid : it->second) {
+            if (sid == except) continue;
+            out.push_back({ sid, msg.to_payload() });
+            stats.delivered++;
+        }
+    }
+
+    void deliver(SessionId from, const std::string& src, const std::string& dst, const std::string& text, std::vector<Outgoing>& out) {
+        if (dst.empty()) return;
+
+        auto& chat = history[historyKey(src, dst)];
+        Message stored { chat.size() + 1, Datetime::now().toTime(), src, dst, text };
+        chat.push_back(stored);
+
+        SessionId except = echo ? (SessionId)-1 : from;
+
+        if (dst[0] == '@') {
+            if (online[dst].empty()) unread[dst].insert({ src, stored.get_id() });
+            else sendTo(dst, stored, except, out);
+            if (echo) sendTo(src, stored, (SessionId)-1, out);
+            return;
+        }
+
+        if (dst == ":all") {
+            for (auto& [user, list] : online) sendTo(user, stored, except, out);
+            return;
+        }
+
+        for (auto& user : members[dst]) {
+            if (online[user].empty()) unread[user].insert({ dst, stored.get_id() });
+            else sendTo(user, stored, except, out);
+        }
+    }
+
+    std::string request(SessionId id, const std::string& req) {
+        auto& session = sessions[id];
+
+        std::string buffer = req;
+        std::vector<std::string> args;
+        for (auto token : Tokenizer(buffer)) args.emplace_back(token);
+        if (args.empty()) return "-";
+
+        auto arg = [&](size_t i) -> const std::string& {
+            static const std::string none;
+            return i < args.size() ? args[i] : none;
+        };
+
+        const auto& com = args[0];
+        const auto& user = session.user;
+
+        if (com == "!register") {
+            if (passwords.count(arg(1))) return "fail_username";
+            passwords[arg(1)] = arg(2);
+            login(id, arg(1));
+            return "success";
+        }
+        if (com == "!login") {
+            auto it = passwords.find(arg(1));
+            if (it == passwords.end()) return "fail_username";
+            if (it->second != arg(2)) return "fail_password";
+            login(id, arg(1));
+            return "success";
+        }
+
+        if (com == "!ping") return "pong";
+        if (user.empty()) return "-";
+
+        if (com == "!create") {
+            if (members.count(arg(1)) || arg(1) == ":all") return "-";
+            members[arg(1)];
+            return "+";
+        }
+        if (com == "!join") {
+            if (arg(1) != ":all" && !members.count(arg(1))) return "-";
+            members[arg(1)].insert(user);
+            return "+";
+        }
+        if (com == "!leave") {
+            return members[arg(1)].erase(user) ? "+" : "-";
+        }
+        if (com == "!chat") {
+            auto& chat = history[historyKey(user, arg(1))];
+            size_t count = args.size() > 2 ? std::stoul(arg(2)) : 50;
+            size_t first = chat.size() > count ? chat.size() - count : 0;
+
+            std::string res;
+            for (size_t i = first; i < chat.size(); i++) {
+                res += chat[i].to_payload();
+                res += PULSAR_SEP;
+            }
+            return res;
+        }
+        if (com == "!msg") {
+            auto& chat = history[historyKey(user, arg(1))];
+            size_t msg_id = std::stoull(arg(2));
+            if (msg_id == 0 || msg_id > chat.size()) return "";
+            return chat[msg_id - 1].to_payload();
+        }
+        if (com == "!getUnread") {
+            std::string res;
+            for (auto& [chat, msg_id] : unread[user]) {
+                if (!res.empty()) res += ';';
+                res += chat + "|" + std::to_string(msg_id);
+            }
+            return res;
+        }
+        if (com == "!read") {
+            return unread[user].erase({ arg(1), std::stoull(arg(2)) }) ? "+" : "-";
+        }
+        if (com == "!readupto") {
+            auto& list = unread[user];
+            size_t up_to = std::stoull(arg(2));
+            std::erase_if(list, [&](auto& entry) { return entry.first == arg(1) && entry.second <= up_to; });
+            return "+";
+        }
+        if (com == "!profile") {
+            if (arg(1) == "get") {
+                auto it = profiles.find(arg(2));
+                if (it != profiles.end()) return it->second;
+                return std::string() + PULSAR_PROFILE_SEP + PULSAR_PROFILE_SEP + PULSAR_PROFILE_SEP + "0";
+            }
+            if (arg(1) == "set") {
+                auto pos = req.find("set ");
+                profiles[user] = req.substr(pos + 4);
+                return "+";
+            }
+            return "-";
+        }
+        if (com == "!contact" || com == "!rsa") {
+            return "+";
+        }
+
+        return "-";
+    }
+
+    void login(SessionId id, const std::string& user) {
+        auto& session = sessions[id];
+        if (session.user == user) return;
+
+        if (!session.user.empty()) {
+            auto& list = online[session.user];
+            list.erase(std::remove(list.begin(), list.end(), id), list.end());
+        }
+        session.user = user;
+        online[user].push_back(id);
+    }
+};
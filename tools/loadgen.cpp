@@ -0,0 +1,266 @@
+#include "defines"
+#include "API/PulsarAPI.hpp"
+#include "API/SessionEngine.hpp"
+#include "lib/hash.h"
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+#include <charconv>
+#include <atomic>
+#include <thread>
+
+#ifndef _WIN32
+#   include <sys/resource.h>
+#   include <unistd.h>
+#endif
+
+// Usage: pulsar-loadgen [--host 127.0.0.1] [--port 4171] [--clients 10] [--rate 10] [--duration 10] [--channel :all] [--engine 0] [--bulk 0]
+// Starts N headless sessions against a (stub) server, each sending `rate` messages per second
+// to `channel`, and reports delivered messages per second, fan-out latency percentiles and CPU/RSS per client.
+// `--channel @peer` sends direct messages to the next client instead (fan-out of one).
+// `--engine L` runs all sessions on a SessionEngine with L loops instead of one PulsarAPI
+// (socket, thread and database) per client. Client databases are created in ./pulsar-loadgen-data.
+// `--bulk N` makes every session load history meanwhile, N `!msg` fetches queued at a time, and time
+// a control request (`!readupto`) issued behind each such batch: latency under load (not with --engine).
+
+using Clock = std::chrono::steady_clock;
+
+static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+struct Client {
+    std::shared_ptr<PulsarAPI> api;     // not used with --engine
+    std::vector<int64_t> latencies;     // ns, written by one reciever thread or loop only
+    size_t received = 0;
+
+    void onMessage(const Message& msg) {
+        // "lg <seq> <send time ns>"
+        // Payloads that arrived glued to the next one (no framing) still parse up to the first bad char
+        auto text = msg.get_msg();
+        if (text.rfind("lg ", 0) != 0) return;
+        auto sp = text.find(' ', 3);
+        if (sp == std::string::npos) return;
+
+        int64_t sent = 0;
+        if (std::from_chars(text.data() + sp + 1, text.data() + text.size(), sent).ec != std::errc()) return;
+
+        latencies.push_back(now_ns() - sent);
+        received++;
+    }
+};
+
+static double cpu_seconds() {
+#ifndef _WIN32
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#else
+    return 0;
+#endif
+}
+
+static size_t rss_bytes() {
+#ifdef __linux__
+    long pages = 0, resident = 0;
+    if (FILE* f = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        std::fclose(f);
+    }
+    return (size_t)resident * sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+int main(int argc, const char** argv) {
+    std::string host = "127.0.0.1";
+    unsigned short port = PULSAR_PORT;
+    size_t clients = 10;
+    double rate = 10;
+    double duration = 10;
+    std::string channel = ":all";
+    size_t engine_loops = 0;
+    size_t bulk = 0;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i], value = argv[i + 1];
+        if (key == "--host") host = value;
+        else if (key == "--port") port = (unsigned short)std::stoi(value);
+        else if (key == "--clients") clients = std::stoul(value);
+        else if (key == "--rate") rate = std::stod(value);
+        else if (key == "--duration") duration = std::stod(value);
+        else if (key == "--channel") channel = value;
+        else if (key == "--engine") engine_loops = std::stoul(value);
+        else if (key == "--bulk") bulk = std::stoul(value);
+        else {
+            std::cout << "Unknown option " << key << std::endl;
+            return 1;
+        }
+    }
+
+    std::filesystem::create_directories("pulsar-loadgen-data");
+    std::filesystem::current_path("pulsar-loadgen-data");
+
+    const auto password = hash("loadgen");
+    const double cpu_start = cpu_seconds();
+    const size_t rss_start = rss_bytes();
+
+    std::vector<Client> sessions(clients);
+    std::unique_ptr<SessionEngine> engine;
+
+    auto name = [](size_t i) { return "@lg" + std::to_string(i); };
+    auto dest = [&](size_t i) { return channel == "@peer" ? name((i + 1) % clients) : channel; };
+
+    if (engine_loops) {
+        engine = std::make_unique<SessionEngine>(engine_loops);
+        engine->setMessageHandler([&](SessionEngine::SessionId id, const Message& msg) {
+            sessions[id].onMessage(msg);
+        });
+
+        for (size_t i = 0; i < clients; i++) {
+            if (engine->open(host, port, name(i), password) == SessionEngine::Invalid) return 1;
+        }
+
+        while (engine->readyCount() < clients) {
+            if (engine->openCount() < clients) {
+                std::cout << "Login failed for " << clients - engine->openCount() << " sessions" << std::endl;
+                return 1;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        if (channel[0] != '@' && channel != ":all") {
+            std::atomic<size_t> joined = 0;
+            engine->request(0, "!create " + channel, [&](const std::string&) {
+                for (size_t i = 0; i < clients; i++) engine->request(i, "!join " + channel, [&](const std::string&) { joined++; });
+            });
+            while (joined < clients) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    } else {
+        for (size_t i = 0; i < clients; i++) {
+            auto& s = sessions[i];
+            s.api = std::make_shared<PulsarAPI>(nullptr, name(i));
+            if (!s.api->connect(host, port)) return 1;
+            s.api->startRecieverLoop();
+
+            if (s.api->login(password) == PulsarAPI::Fail_Username) s.api->registerUser(password);
+            if (channel[0] != '@' && channel != ":all") {
+                if (i == 0) s.api->createChannel(channel);
+                s.api->joinChannel(channel);
+            }
+
+            s.api->setMessageHandler([&s](const Message& msg) { s.onMessage(msg); });
+        }
+    }
+
+    const double cpu_ready = cpu_seconds();
+    const size_t rss_ready = rss_bytes();
+
+    std::cout << clients << (engine ? " engine" : "") << " sessions ready, sending " << rate << " msg/s each to " << channel
+              << " for " << duration << " s" << std::endl;
+
+    // History loads next to the live traffic, one thread per session
+    std::atomic_bool loading = true;
+    std::atomic<size_t> fetched = 0;
+    std::vector<std::vector<int64_t>> control(clients);
+    std::vector<std::thread> loaders;
+    if (bulk && engine) std::cout << "--bulk is ignored with --engine" << std::endl;
+    else if (bulk) {
+        for (size_t i = 0; i < clients; i++) {
+            loaders.emplace_back([&, i] {
+                auto& api = *sessions[i].api;
+                while (loading && api.isConnected()) {
+                    std::vector<Async::Task<std::string>> batch;
+                    for (size_t id = 1; id <= bulk; id++) batch.push_back(api.requestAsync("msg", dest(i), id));
+                    auto sync = Async::whenAll(std::move(batch));
+                    sync.start();
+
+                    auto sent = now_ns();
+                    api.request("readupto", dest(i), 0);
+                    control[i].push_back(now_ns() - sent);
+
+                    fetched += Async::syncWait(std::move(sync)).size();
+                }
+            });
+        }
+    }
+
+    // One pacing thread for all sessions: each session sends every 1/rate seconds
+    const auto interval = std::chrono::nanoseconds((int64_t)(1e9 / rate));
+    const auto start = Clock::now();
+    const auto stop = start + std::chrono::nanoseconds((int64_t)(duration * 1e9));
+
+    std::vector<Clock::time_point> next(clients);
+    for (size_t i = 0; i < clients; i++) next[i] = start + interval * i / clients;
+
+    // Send times are staggered evenly, so sessions come due in round-robin order
+    size_t sent = 0, seq = 0, cursor = 0;
+    while (Clock::now() < stop) {
+        auto now = Clock::now();
+
+        while (next[cursor] <= now) {
+            auto text = "lg " + std::to_string(seq++) + " " + std::to_string(now_ns());
+            if (engine) engine->send(cursor, text, dest(cursor));
+            else sessions[cursor].api->send(text, dest(cursor));
+            sent++;
+
+            next[cursor] += interval;
+            cursor = (cursor + 1) % clients;
+        }
+
+        std::this_thread::sleep_until(std::min(next[cursor], stop));
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::this_thread::sleep_for(std::chrono::seconds(1)); // let in-flight messages arrive
+    loading = false;
+    for (auto& t : loaders) t.join();
+
+    const double cpu_end = cpu_seconds();
+
+    std::vector<int64_t> all;
+    size_t received = 0;
+    if (engine) engine.reset();  // joins the loops
+    for (auto& s : sessions) {
+        if (s.api) s.api->setMessageHandler(nullptr);
+        received += s.received;
+        all.insert(all.end(), s.latencies.begin(), s.latencies.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    std::vector<int64_t> requests;
+    for (auto& c : control) requests.insert(requests.end(), c.begin(), c.end());
+    std::sort(requests.begin(), requests.end());
+
+    auto pct_of = [](const std::vector<int64_t>& sorted, double p) -> double {
+        if (sorted.empty()) return 0;
+        return sorted[std::min(sorted.size() - 1, (size_t)(p / 100 * sorted.size()))] / 1e6;
+    };
+    auto pct = [&](double p) { return pct_of(all, p); };
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "sent:             " << sent << " (" << sent / elapsed << " msg/s)\n";
+    std::cout << "delivered:        " << received << " (" << received / elapsed << " msg/s)\n";
+    std::cout << "latency ms:       p50 " << pct(50) << "  p90 " << pct(90) << "  p99 " << pct(99) << "  max " << pct(100) << "\n";
+    if (!loaders.empty()) {
+        std::cout << "history fetched:  " << fetched << " (" << fetched / elapsed << " msg/s)\n";
+        std::cout << "control ms:       p50 " << pct_of(requests, 50) << "  p90 " << pct_of(requests, 90) << "  p99 " << pct_of(requests, 99)
+                  << "  max " << pct_of(requests, 100) << " (" << requests.size() << " requests behind history batches)\n";
+    }
+    std::cout << "cpu per client:   " << (cpu_ready - cpu_start) * 1000 / clients << " ms setup, "
+              << (cpu_end - cpu_ready) * 1000 / clients / elapsed << " ms/s under load\n";
+    std::cout << "rss per client:   " << (rss_ready > rss_start ? (rss_ready - rss_start) / 1024.0 / clients : 0.0) << " KiB"
+              << " (process " << rss_bytes() / 1024 << " KiB)" << std::endl;
+
+    for (auto& s : sessions) {
+        if (s.api) s.api->disconnect();
+    }
+
+    return 0;
+}
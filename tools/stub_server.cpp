@@ -0,0 +1,137 @@
+#include "defines"
+#include "StubServer.hpp"
+#include "Network/Poller.hpp"
+#include <SFML/Network.hpp>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <cstring>
+
+// Usage: pulsar-stub-server [--port 4171] [--echo]
+// Speaks the Pulsar protocol on loopback, keeps all state in memory.
+int main(int argc, const char** argv) {
+    unsigned short port = PULSAR_PORT;
+    bool echo = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--port") && i + 1 < argc) port = (unsigned short)std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--echo")) echo = true;
+        else {
+            std::cout << "Usage: " << argv[0] << " [--port " << PULSAR_PORT << "] [--echo]" << std::endl;
+            return 1;
+        }
+    }
+
+    PollableListener listener;
+    if (listener.listen(port, sf::IpAddress::LocalHost) != sf::Socket::Status::Done) {
+        std::cout << "Cannot listen on 127.0.0.1:" << port << std::endl;
+        return 1;
+    }
+    std::cout << "Pulsar stub server listening on 127.0.0.1:" << port << std::endl;
+
+    // Outgoing payloads are sent one per send() (the protocol has no framing),
+    // whatever the socket does not take right away waits for Poller::Write
+    struct Connection {
+        StubServer::SessionId id;
+        PollableSocket socket;
+        std::vector<std::string> out;
+        size_t out_head = 0;
+        size_t out_pos = 0;
+        bool writing = false;
+        bool closed = false;
+    };
+
+    StubServer server { echo };
+    std::unordered_map<StubServer::SessionId, std::unique_ptr<Connection>> connections;
+    std::vector<StubServer::SessionId> closed;
+    StubServer::SessionId next_id = 1;
+
+    Poller poller;
+    listener.setBlocking(false);
+    poller.add(listener.getNativeHandle(), Poller::Read, &listener);
+
+    auto close = [&](Connection& conn) {
+        if (conn.closed) return;
+        conn.closed = true;
+        poller.remove(conn.socket.getNativeHandle());
+        conn.socket.disconnect();
+        server.disconnected(conn.id);
+        closed.push_back(conn.id);
+    };
+
+    auto flush = [&](Connection& conn) {
+        while (conn.out_head < conn.out.size()) {
+            auto& data = conn.out[conn.out_head];
+            size_t sent = 0;
+            auto status = conn.socket.send(data.data() + conn.out_pos, data.size() - conn.out_pos, sent);
+            conn.out_pos += sent;
+
+            if (status == sf::Socket::Status::Done) {
+                conn.out_head++;
+                conn.out_pos = 0;
+            } else if (status == sf::Socket::Status::Partial || status == sf::Socket::Status::NotReady) {
+                if (!conn.writing) poller.modify(conn.socket.getNativeHandle(), Poller::Read | Poller::Write, &conn);
+                conn.writing = true;
+                return;
+            } else {
+                close(conn);
+                return;
+            }
+        }
+
+        conn.out.clear();
+        conn.out_head = 0;
+        if (conn.writing) poller.modify(conn.socket.getNativeHandle(), Poller::Read, &conn);
+        conn.writing = false;
+    };
+
+    std::vector<Poller::Event> events;
+    std::vector<StubServer::Outgoing> out;
+    char buffer[PULSAR_PACKET_SIZE];
+
+    while (true) {
+        poller.wait(events, -1);
+        out.clear();
+
+        for (auto& ev : events) {
+            if (ev.data == &listener) {
+                while (true) {
+                    auto conn = std::make_unique<Connection>();
+                    if (listener.accept(conn->socket) != sf::Socket::Status::Done) break;
+
+                    conn->id = next_id++;
+                    conn->socket.setBlocking(false);
+                    server.connected(conn->id);
+                    poller.add(conn->socket.getNativeHandle(), Poller::Read, conn.get());
+                    connections[conn->id] = std::move(conn);
+                }
+                continue;
+            }
+
+            auto& conn = *static_cast<Connection*>(ev.data);
+            if (conn.closed) continue;
+
+            if (ev.events & (Poller::Read | Poller::Hangup)) {
+                size_t received = 0;
+                auto status = conn.socket.receive(buffer, sizeof(buffer), received);
+
+                if (status == sf::Socket::Status::Done) server.handle(conn.id, std::string_view(buffer, received), out);
+                else if (status != sf::Socket::Status::NotReady) close(conn);
+            }
+            if ((ev.events & Poller::Write) && !conn.closed) flush(conn);
+        }
+
+        for (auto& o : out) {
+            auto it = connections.find(o.to);
+            if (it == connections.end() || it->second->closed) continue;
+
+            auto& conn = *it->second;
+            conn.out.push_back(std::move(o.payload));
+            if (!conn.writing) flush(conn);
+        }
+
+        for (auto id : closed) connections.erase(id);
+        closed.clear();
+    }
+}